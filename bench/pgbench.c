@@ -0,0 +1,227 @@
+/* pgbench.c - pgbench, pgb_run, pgb_worker */
+
+#include <conf.h>
+#include <kernel.h>
+#include <proc.h>
+#include <sem.h>
+#include <sleep.h>
+#include <paging.h>
+#include <stdio.h>
+
+/*
+ * Paging stress benchmark.  Each run starts nproc workers that map
+ * backing stores of their own at PGB_VPNO and touch them with one
+ * access pattern; every combination is repeated under each replacement
+ * policy.  Each run prints one line of key=value pairs:
+ *
+ *	pgbench policy= pattern= procs= pages= accesses= ms=
+ *		faults= faults_per_s= faults_per_kacc= evict= wback=
+ *		cyc_per_acc=
+ *
+ * pages is the total distinct pages touched, faults, evict and wback
+ * count only the workers' own pages, and cyc_per_acc is wall-clock TSC
+ * cycles over all accesses.  An access is one word; every fourth is a
+ * store.
+ */
+
+#define	PGB_SEQ		0		/* 64-byte steps through the set*/
+#define	PGB_RAND	1		/* uniform page, random line	*/
+#define	PGB_STRIDE	2		/* every PGB_STEP'th page	*/
+#define	PGB_ZIPF	3		/* page i with weight 1/(i+1)	*/
+
+#define	PGB_VPNO	0x10000		/* first page of a worker's set	*/
+#define	PGB_STORES	8		/* backing stores available	*/
+#define	PGB_SPAGES	256		/* pages per store		*/
+#define	PGB_MAXPG	(PGB_STORES * PGB_SPAGES)
+#define	PGB_MAXPROC	4
+#define	PGB_STEP	7		/* stride, in pages		*/
+#define	PGB_ACCESS	200000		/* accesses per worker		*/
+#define	PGB_STK		4096		/* worker stack, in words	*/
+#define	PGB_PRIO	20
+
+struct	pgbrun	{
+	int	r_pattern;
+	int	r_nproc;
+	int	r_nstores;		/* stores per worker		*/
+};
+
+LOCAL	struct	pgbrun	pgb_runs[] = {
+	{ PGB_SEQ,	1, 3 },
+	{ PGB_RAND,	1, 3 },
+	{ PGB_STRIDE,	1, 3 },
+	{ PGB_ZIPF,	1, 3 },
+	{ PGB_SEQ,	1, 6 },	/* working set > NFRAMES	*/
+	{ PGB_RAND,	1, 6 },
+	{ PGB_ZIPF,	1, 6 },
+	{ PGB_RAND,	4, 2 },
+	{ PGB_ZIPF,	4, 2 },
+};
+#define	NPGBRUNS	(sizeof(pgb_runs) / sizeof(struct pgbrun))
+
+LOCAL	char	*pgb_pname[] = { "seq", "rand", "stride", "zipf" };
+
+struct	pgbres	{
+	unsigned long	b_faults;
+	unsigned long	b_evict;
+	unsigned long	b_wback;
+	int	b_ok;			/* worker mapped its stores	*/
+};
+
+LOCAL	struct	pgbres	pgb_res[PGB_MAXPROC];
+LOCAL	unsigned long	pgb_cdf[PGB_MAXPG];	/* Zipf cumulative weights */
+LOCAL	int	pgb_done;		/* semaphore signalled by workers */
+
+LOCAL	void	pgb_worker(int, int, int, int, int);
+LOCAL	void	pgb_run(struct pgbrun *);
+
+/*------------------------------------------------------------------------
+ * pgbench - run every benchmark under every page replacement policy
+ *------------------------------------------------------------------------
+ */
+void pgbench(void)
+{
+	int	policies[2], oldpol, p, r;
+
+	policies[0] = SC;
+	policies[1] = AGING;
+	oldpol = grpolicy();
+	if ((pgb_done = screate(0)) == SYSERR) {
+		kprintf("pgbench: no semaphore\n");
+		return;
+	}
+	for (p = 0; p < 2; p++) {
+		srpolicy(policies[p]);
+		for (r = 0; r < NPGBRUNS; r++)
+			pgb_run(&pgb_runs[r]);
+	}
+	srpolicy(oldpol);
+	sdelete(pgb_done);
+}
+
+/*------------------------------------------------------------------------
+ * pgb_run - start the workers for one run, wait, and print the results
+ *------------------------------------------------------------------------
+ */
+LOCAL void pgb_run(struct pgbrun *run)
+{
+	unsigned long	faults, evict, wback, acc, ms, t0ms;
+	unsigned long long t0;
+	int	npages, i, pid, store, started;
+
+	npages = run->r_nstores * PGB_SPAGES;
+	if (run->r_pattern == PGB_ZIPF)
+		for (i = 0; i < npages; i++)
+			pgb_cdf[i] = (i ? pgb_cdf[i - 1] : 0) + 65536 / (i + 1);
+
+	bzero(pgb_res, sizeof(pgb_res));
+	started = 0;
+	t0 = read_tsc();
+	t0ms = ctr1000;
+	for (i = 0; i < run->r_nproc; i++) {
+		store = i * run->r_nstores;
+		pid = create((int *) pgb_worker, PGB_STK, PGB_PRIO, "pgbench", 5,
+			i, run->r_pattern, store, run->r_nstores, i + 1);
+		if (pid == SYSERR)
+			break;
+		resume(pid);
+		started++;
+	}
+	for (i = 0; i < started; i++)
+		wait(pgb_done);
+	ms = ctr1000 - t0ms;
+	t0 = read_tsc() - t0;
+
+	faults = evict = wback = 0;
+	for (i = 0; i < started; i++) {
+		if (!pgb_res[i].b_ok)
+			started = -1;
+		faults += pgb_res[i].b_faults;
+		evict += pgb_res[i].b_evict;
+		wback += pgb_res[i].b_wback;
+	}
+	if (started != run->r_nproc) {
+		kprintf("pgbench policy=%s pattern=%s procs=%d error=setup\n",
+			grpolicy() == SC ? "SC" : "AGING",
+			pgb_pname[run->r_pattern], run->r_nproc);
+		return;
+	}
+	acc = (unsigned long) run->r_nproc * PGB_ACCESS;
+	kprintf("pgbench policy=%s pattern=%s procs=%d pages=%d "
+		"accesses=%lu ms=%lu faults=%lu faults_per_s=%lu "
+		"faults_per_kacc=%lu evict=%lu wback=%lu cyc_per_acc=%lu\n",
+		grpolicy() == SC ? "SC" : "AGING", pgb_pname[run->r_pattern],
+		run->r_nproc, npages * run->r_nproc, acc, ms,
+		faults, ms ? faults * 1000 / ms : 0, faults * 1000 / acc,
+		evict, wback, div64(t0, acc));
+}
+
+/*------------------------------------------------------------------------
+ * pgb_worker - map nstores stores from store up and run one pattern
+ *------------------------------------------------------------------------
+ */
+LOCAL void pgb_worker(int slot, int pattern, int store, int nstores,
+	int seed)
+{
+	struct	vmstat	vs;
+	unsigned long	rnd, total, off, span, x;
+	int	npages, i, page, lo, hi, mid;
+	volatile int *base;
+
+	npages = nstores * PGB_SPAGES;
+	for (i = 0; i < nstores; i++)
+		if (get_bs(store + i, PGB_SPAGES) == SYSERR ||
+		    xmmap(PGB_VPNO + i * PGB_SPAGES, store + i,
+		    PGB_SPAGES) == SYSERR)
+			break;
+	if (i < nstores) {
+		nstores = i;
+		goto out;
+	}
+
+	base = (volatile int *) (PGB_VPNO * NBPG);
+	span = (unsigned long) npages * NBPG;
+	total = pattern == PGB_ZIPF ? pgb_cdf[npages - 1] : 0;
+	rnd = seed;
+	for (i = 0, off = 0; i < PGB_ACCESS; i++) {
+		rnd = rnd * 1103515245 + 12345;
+		x = rnd >> 8;
+		switch (pattern) {
+		case PGB_SEQ:
+			off = (unsigned long) i * 64 % span;
+			break;
+		case PGB_RAND:
+			off = (x % npages) * NBPG + (x & 0xfc0);
+			break;
+		case PGB_STRIDE:
+			page = (int) ((unsigned long) i * PGB_STEP % npages);
+			off = (unsigned long) page * NBPG + (i & 0x3f) * 64;
+			break;
+		case PGB_ZIPF:
+			x %= total;
+			for (lo = 0, hi = npages - 1; lo < hi; ) {
+				mid = (lo + hi) / 2;
+				if (pgb_cdf[mid] <= x)
+					lo = mid + 1;
+				else
+					hi = mid;
+			}
+			off = (unsigned long) lo * NBPG + (rnd & 0xfc0);
+			break;
+		}
+		if ((i & 3) == 0)
+			base[off / sizeof(int)] = i;
+		else
+			x = base[off / sizeof(int)];
+	}
+	pgb_res[slot].b_ok = 1;
+
+out:
+	if (getvmstat(getpid(), &vs) == OK) {
+		pgb_res[slot].b_faults = vs.vs_majflt + vs.vs_minflt;
+		pgb_res[slot].b_evict = vs.vs_evict;
+		pgb_res[slot].b_wback = vs.vs_wback;
+	}
+	for (i = 0; i < nstores; i++)
+		xmunmap(PGB_VPNO + i * PGB_SPAGES);
+	signal(pgb_done);
+}
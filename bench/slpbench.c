@@ -0,0 +1,109 @@
+/* slpbench.c - slpbench, slb_run, slb_worker */
+
+#include <conf.h>
+#include <kernel.h>
+#include <proc.h>
+#include <q.h>
+#include <sleep.h>
+#include <paging.h>
+#include <stdio.h>
+
+/*
+ * Sleep queue benchmark.  Each run parks nsleep processes on the timing
+ * wheel with wake times spread over the wheel's levels, then times with
+ * interrupts disabled:
+ *
+ *	slpbench sleepers= ins_cyc= ins_max= tick_cyc= tick_max=
+ *
+ * ins_cyc is TSC cycles for putting one more process to sleep and
+ * cancelling it (twinsert and twremove, what sleep10 and unsleep do),
+ * tick_cyc the clock's share of a tick (twadvance by one ms, cascades
+ * included) with nobody waking, each averaged, with the worst case in
+ * the _max fields.  Both should stay flat as sleepers grows.  The
+ * workers are never resumed.  Ticking the wheel by hand wakes anything
+ * else asleep that much early, so run it on an otherwise idle system.
+ */
+
+#define	SLB_INS		10000		/* insert/cancel pairs timed	*/
+#define	SLB_TICKS	(4 * TW_SLOTS * TW_SLOTS)	/* ticks timed	*/
+#define	SLB_FIRST	(2 * SLB_TICKS)	/* earliest parked wake time	*/
+#define	SLB_STK		1024		/* worker stack, in words	*/
+
+LOCAL	void	slb_run(int);
+LOCAL	void	slb_worker(void);
+
+/*------------------------------------------------------------------------
+ * slpbench - time sleep and tick costs against the number of sleepers
+ *------------------------------------------------------------------------
+ */
+void slpbench(void)
+{
+	int	n;
+
+	for (n = 0; n < NPROC - 10; n = n ? 2 * n : 1)
+		slb_run(n);
+	slb_run(NPROC - 10);
+}
+
+/*------------------------------------------------------------------------
+ * slb_run - one timed run with nsleep processes parked on the wheel
+ *------------------------------------------------------------------------
+ */
+LOCAL void slb_run(int nsleep)
+{
+	STATWORD ps;
+	unsigned long long t0;
+	unsigned long	cyc, sum, max, isum, imax;
+	int	pids[NPROC], i, pid, n, prio;
+
+	prio = getprio(getpid()) > 1 ? getprio(getpid()) - 1 : 1;
+	for (n = 0; n <= nsleep; n++) {	/* the last one is timed	*/
+		pids[n] = create((int *) slb_worker, SLB_STK, prio, "slpbench",
+			0, 0);
+		if (pids[n] == SYSERR) {
+			kprintf("slpbench sleepers=%d error=create\n", nsleep);
+			while (--n >= 0)
+				kill(pids[n]);
+			return;
+		}
+	}
+	pid = pids[nsleep];
+	disable(ps);
+	for (n = 0; n < nsleep; n++)	/* 30 s to about 4.7 hours out	*/
+		twinsert(pids[n], SLB_FIRST + (n * 2654435761UL) % TW_RANGE);
+	isum = imax = 0;
+	for (i = 0; i < SLB_INS; i++) {
+		t0 = read_tsc();
+		twinsert(pid, 1 + i % (TW_SLOTS * TW_SLOTS));
+		twremove(pid);
+		cyc = (unsigned long) (read_tsc() - t0);
+		isum += cyc;
+		if (cyc > imax)
+			imax = cyc;
+	}
+	sum = max = 0;
+	for (i = 0; i < SLB_TICKS; i++) {
+		t0 = read_tsc();
+		twadvance(1);
+		cyc = (unsigned long) (read_tsc() - t0);
+		sum += cyc;
+		if (cyc > max)
+			max = cyc;
+	}
+	for (n = 0; n < nsleep; n++)
+		twremove(pids[n]);
+	restore(ps);
+	for (n = 0; n <= nsleep; n++)
+		kill(pids[n]);
+	kprintf("slpbench sleepers=%d ins_cyc=%lu ins_max=%lu tick_cyc=%lu "
+		"tick_max=%lu\n", nsleep, isum / SLB_INS, imax,
+		sum / SLB_TICKS, max);
+}
+
+/*------------------------------------------------------------------------
+ * slb_worker - never runs: it is killed while still suspended
+ *------------------------------------------------------------------------
+ */
+LOCAL void slb_worker(void)
+{
+}
@@ -0,0 +1,84 @@
+/* stkbench.c - stkbench, stb_run, stb_worker */
+
+#include <conf.h>
+#include <kernel.h>
+#include <proc.h>
+#include <sleep.h>
+#include <mem.h>
+#include <paging.h>
+#include <stdio.h>
+
+/*
+ * Process creation benchmark.  Each run creates, resumes and kills
+ * STB_PROCS processes one after another, with the stack cache off and
+ * then on, for a small and a large stack.  The workers get a lower
+ * priority than the caller so they never run.  Each run prints:
+ *
+ *	stkbench cache= ssize= procs= ms= cyc_per_proc= heap_frag=
+ *
+ * cyc_per_proc is TSC cycles for one create/resume/kill and heap_frag
+ * is the kernel heap's fragmentation afterwards, per mille.
+ */
+
+#define	STB_PROCS	5000
+#define	STB_SMALL	1024		/* stack sizes, in words	*/
+#define	STB_LARGE	16384
+
+LOCAL	void	stb_run(int, int);
+LOCAL	void	stb_worker(void);
+
+/*------------------------------------------------------------------------
+ * stkbench - time create/resume/kill without and with the stack cache
+ *------------------------------------------------------------------------
+ */
+void stkbench(void)
+{
+	int	cap;
+
+	cap = stkc_setcap(0);
+	stb_run(0, STB_SMALL);
+	stb_run(0, STB_LARGE);
+	stkc_setcap(cap);
+	stb_run(cap, STB_SMALL);
+	stb_run(cap, STB_LARGE);
+	stkc_print();
+}
+
+/*------------------------------------------------------------------------
+ * stb_run - one timed run with ssize-word stacks
+ *------------------------------------------------------------------------
+ */
+LOCAL void stb_run(int cap, int ssize)
+{
+	struct	memstat	ms;
+	unsigned long long t0;
+	unsigned long	t0ms, msecs;
+	int	i, pid, prio;
+
+	prio = getprio(getpid()) > 1 ? getprio(getpid()) - 1 : 1;
+	t0ms = ctr1000;
+	t0 = read_tsc();
+	for (i = 0; i < STB_PROCS; i++) {
+		pid = create((int *) stb_worker, ssize, prio, "stkbench", 0, 0);
+		if (pid == SYSERR || resume(pid) == SYSERR ||
+		    kill(pid) == SYSERR) {
+			kprintf("stkbench cache=%s error=create\n",
+				cap ? "on" : "off");
+			return;
+		}
+	}
+	t0 = read_tsc() - t0;
+	msecs = ctr1000 - t0ms;
+	getmemstat(&ms);
+	kprintf("stkbench cache=%s ssize=%d procs=%d ms=%lu cyc_per_proc=%lu "
+		"heap_frag=%lu\n", cap ? "on" : "off", ssize, STB_PROCS, msecs,
+		div64(t0, STB_PROCS), ms.ms_frag);
+}
+
+/*------------------------------------------------------------------------
+ * stb_worker - never runs: it is killed while still ready
+ *------------------------------------------------------------------------
+ */
+LOCAL void stb_worker(void)
+{
+}
@@ -0,0 +1,97 @@
+/* tmbench.c - tmbench, tmb_run, tmb_fire */
+
+#include <conf.h>
+#include <kernel.h>
+#include <proc.h>
+#include <sleep.h>
+#include <timer.h>
+#include <stdio.h>
+
+/*
+ * Microsecond timer benchmark.  For each delay it sleeps with sleepus()
+ * and, separately, sets a timer and spins until its callback runs,
+ * TMB_ROUNDS times, timing each with gettime_ns():
+ *
+ *	tmbench what= us= late_ns= late_max= early=
+ *
+ * late_ns is how long after the delay the caller ran again (sleepus) or
+ * the callback ran (timer), averaged, with the worst case in late_max;
+ * early counts the rounds that came back before the delay was up, which
+ * should be none.  Run it on an otherwise idle system.
+ */
+
+#define	TMB_ROUNDS	200
+
+LOCAL	unsigned long	tmb_us[] = { 20, 50, 100, 250, 500, 1000, 2500, 10000 };
+
+LOCAL	void	tmb_run(int, unsigned long);
+LOCAL	void	tmb_fire(int);
+
+LOCAL	volatile unsigned long long tmb_fired;	/* callback ran at */
+
+/*------------------------------------------------------------------------
+ * tmbench - time sleepus() and timer callbacks over a range of delays
+ *------------------------------------------------------------------------
+ */
+void tmbench(void)
+{
+	int	tm, i;
+
+	kprintf("tmbench tsc_khz=%lu\n", tsckhz);
+	if ((tm = tmcreate(tmb_fire, 0)) == SYSERR) {
+		kprintf("tmbench error=tmcreate\n");
+		return;
+	}
+	for (i = 0; i < sizeof(tmb_us) / sizeof(tmb_us[0]); i++) {
+		tmb_run(SYSERR, tmb_us[i]);
+		tmb_run(tm, tmb_us[i]);
+	}
+	tmdelete(tm);
+}
+
+/*------------------------------------------------------------------------
+ * tmb_run - TMB_ROUNDS delays of us, by sleepus() or by timer tm
+ *------------------------------------------------------------------------
+ */
+LOCAL void tmb_run(int tm, unsigned long us)
+{
+	unsigned long long t0, t1;
+	unsigned long	late, sum, max, early;
+	int	i;
+
+	sum = max = early = 0;
+	for (i = 0; i < TMB_ROUNDS; i++) {
+		t0 = gettime_ns();
+		if (tm == SYSERR) {
+			sleepus(us);
+			t1 = gettime_ns();
+		} else {
+			tmb_fired = 0;
+			tmstart(tm, us);
+			while (tmb_fired == 0)
+				;
+			t1 = tmb_fired;
+		}
+		t0 += (unsigned long long) us * 1000;
+		if (t1 < t0) {
+			early++;
+			continue;
+		}
+		late = (unsigned long) (t1 - t0);
+		sum += late;
+		if (late > max)
+			max = late;
+	}
+	kprintf("tmbench what=%s us=%lu late_ns=%lu late_max=%lu early=%lu\n",
+		tm == SYSERR ? "sleepus" : "timer", us,
+		early < TMB_ROUNDS ? sum / (TMB_ROUNDS - early) : 0, max, early);
+}
+
+/*------------------------------------------------------------------------
+ * tmb_fire - the timer's callback: note when it ran
+ *------------------------------------------------------------------------
+ */
+LOCAL void tmb_fire(int arg)
+{
+	tmb_fired = gettime_ns();
+}
@@ -0,0 +1,238 @@
+/* vmbench.c - vmbench, vmb_run, vmb_worker */
+
+#include <conf.h>
+#include <kernel.h>
+#include <proc.h>
+#include <sem.h>
+#include <sleep.h>
+#include <mem.h>
+#include <paging.h>
+#include <stdio.h>
+
+/*
+ * Private heap allocation benchmark.  A worker with a VMB_PAGES page
+ * heap runs the same random mix of allocations and frees against two
+ * allocators: vgetmem()/vfreemem(), and the first-fit free list they
+ * used to be, kept here as vmb_ffget()/vmb_fffree() over an xmmap()ed
+ * store at the same address.  Each run prints one line:
+ *
+ *	vmbench alloc= ops= allocs= frees= failed= ms= faults=
+ *		cyc_per_op=
+ *
+ * faults counts the worker's own page faults and cyc_per_op is TSC
+ * cycles per allocation or free, timing only the allocator calls.
+ */
+
+#define	VMB_SEGFIT	0		/* vgetmem / vfreemem		*/
+#define	VMB_FIRSTFIT	1		/* the old first-fit list	*/
+
+#define	VMB_VPNO	4096		/* where vcreate() puts a heap	*/
+#define	VMB_PAGES	256
+#define	VMB_STORE	7		/* store for the first-fit heap	*/
+#define	VMB_SLOTS	512		/* live allocations at most	*/
+#define	VMB_OPS		50000
+#define	VMB_STK		4096		/* worker stack, in words	*/
+#define	VMB_PRIO	20
+
+struct	vmbres	{
+	unsigned long	b_allocs;
+	unsigned long	b_frees;
+	unsigned long	b_failed;
+	unsigned long	b_faults;
+	unsigned long long b_cycles;
+	int	b_ok;			/* worker set up its heap	*/
+};
+
+LOCAL	char	*vmb_aname[] = { "segfit", "firstfit" };
+LOCAL	struct	vmbres	vmb_res;
+LOCAL	WORD	*vmb_ptr[VMB_SLOTS];
+LOCAL	unsigned vmb_len[VMB_SLOTS];
+LOCAL	struct	mblock	vmb_fflist;	/* head of the first-fit list	*/
+LOCAL	int	vmb_done;		/* semaphore signalled by worker */
+
+LOCAL	void	vmb_worker(int);
+LOCAL	void	vmb_run(int);
+LOCAL	WORD	*vmb_ffget(unsigned);
+LOCAL	int	vmb_fffree(struct mblock *, unsigned);
+
+/*------------------------------------------------------------------------
+ * vmbench - run the allocation mix under both allocators
+ *------------------------------------------------------------------------
+ */
+void vmbench(void)
+{
+	if ((vmb_done = screate(0)) == SYSERR) {
+		kprintf("vmbench: no semaphore\n");
+		return;
+	}
+	vmb_run(VMB_SEGFIT);
+	vmb_run(VMB_FIRSTFIT);
+	sdelete(vmb_done);
+}
+
+/*------------------------------------------------------------------------
+ * vmb_run - start one worker, wait for it, and print the results
+ *------------------------------------------------------------------------
+ */
+LOCAL void vmb_run(int alloc)
+{
+	unsigned long	ops, ms, t0ms;
+	int	pid;
+
+	bzero(&vmb_res, sizeof(vmb_res));
+	if (alloc == VMB_SEGFIT)
+		pid = vcreate((int *) vmb_worker, VMB_STK, VMB_PAGES, VMB_PRIO,
+			"vmbench", 1, alloc);
+	else
+		pid = create((int *) vmb_worker, VMB_STK, VMB_PRIO, "vmbench",
+			1, alloc);
+	t0ms = ctr1000;
+	if (pid == SYSERR || resume(pid) == SYSERR) {
+		kprintf("vmbench alloc=%s error=create\n", vmb_aname[alloc]);
+		return;
+	}
+	wait(vmb_done);
+	ms = ctr1000 - t0ms;
+
+	if (!vmb_res.b_ok) {
+		kprintf("vmbench alloc=%s error=setup\n", vmb_aname[alloc]);
+		return;
+	}
+	ops = vmb_res.b_allocs + vmb_res.b_frees + vmb_res.b_failed;
+	kprintf("vmbench alloc=%s ops=%lu allocs=%lu frees=%lu failed=%lu "
+		"ms=%lu faults=%lu cyc_per_op=%lu\n", vmb_aname[alloc], ops,
+		vmb_res.b_allocs, vmb_res.b_frees, vmb_res.b_failed, ms,
+		vmb_res.b_faults, div64(vmb_res.b_cycles, ops));
+}
+
+/*------------------------------------------------------------------------
+ * vmb_worker - set up the heap and run VMB_OPS allocations and frees:
+ *              mostly small objects, some of a few KB, a few of pages
+ *------------------------------------------------------------------------
+ */
+LOCAL void vmb_worker(int alloc)
+{
+	struct	vmstat	vs;
+	unsigned long	rnd, x, faults0;
+	unsigned long long t0;
+	WORD	*p;
+	int	i, slot, ok;
+
+	if (alloc == VMB_FIRSTFIT) {
+		if (get_bs(VMB_STORE, VMB_PAGES) == SYSERR ||
+		    xmmap(VMB_VPNO, VMB_STORE, VMB_PAGES) == SYSERR)
+			goto out;
+		vmb_fflist.mnext = (struct mblock *) (VMB_VPNO * NBPG);
+		vmb_fflist.mnext->mnext = NULL;
+		vmb_fflist.mnext->mlen = VMB_PAGES * NBPG;
+	}
+	for (slot = 0; slot < VMB_SLOTS; slot++)
+		vmb_ptr[slot] = NULL;
+	faults0 = getvmstat(getpid(), &vs) == OK ?
+		vs.vs_majflt + vs.vs_minflt : 0;
+
+	rnd = 1;
+	for (i = 0; i < VMB_OPS; i++) {
+		rnd = rnd * 1103515245 + 12345;
+		x = rnd >> 8;
+		slot = x % VMB_SLOTS;
+		if (vmb_ptr[slot] != NULL) {
+			t0 = read_tsc();
+			if (alloc == VMB_SEGFIT)
+				ok = vfreemem((struct mblock *) vmb_ptr[slot],
+					vmb_len[slot]);
+			else
+				ok = vmb_fffree((struct mblock *) vmb_ptr[slot],
+					vmb_len[slot]);
+			vmb_res.b_cycles += read_tsc() - t0;
+			vmb_ptr[slot] = NULL;
+			if (ok == SYSERR)
+				vmb_res.b_failed++;
+			else
+				vmb_res.b_frees++;
+			continue;
+		}
+		x >>= 9;
+		if ((x & 63) == 0)
+			vmb_len[slot] = NBPG + (x >> 6) % (3 * NBPG);
+		else if ((x & 7) == 0)
+			vmb_len[slot] = 512 + (x >> 6) % 1536;
+		else
+			vmb_len[slot] = 8 + (x >> 6) % 248;
+		t0 = read_tsc();
+		p = alloc == VMB_SEGFIT ? vgetmem(vmb_len[slot]) :
+			vmb_ffget(vmb_len[slot]);
+		vmb_res.b_cycles += read_tsc() - t0;
+		if (p == (WORD *) SYSERR) {
+			vmb_res.b_failed++;
+			continue;
+		}
+		*p = i;				/* the caller uses the block */
+		vmb_ptr[slot] = p;
+		vmb_res.b_allocs++;
+	}
+	if (getvmstat(getpid(), &vs) == OK)
+		vmb_res.b_faults = vs.vs_majflt + vs.vs_minflt - faults0;
+	vmb_res.b_ok = 1;
+	if (alloc == VMB_FIRSTFIT)
+		xmunmap(VMB_VPNO);
+out:
+	signal(vmb_done);
+}
+
+/*------------------------------------------------------------------------
+ * vmb_ffget - first-fit allocation from vmb_fflist (the old vgetmem)
+ *------------------------------------------------------------------------
+ */
+LOCAL WORD *vmb_ffget(unsigned nbytes)
+{
+	struct	mblock	*p, *q, *leftover;
+
+	nbytes = (unsigned int) roundmb(nbytes);
+	for (q = &vmb_fflist, p = vmb_fflist.mnext; p != NULL;
+	     q = p, p = p->mnext)
+		if (p->mlen == nbytes) {
+			q->mnext = p->mnext;
+			return((WORD *) p);
+		} else if (p->mlen > nbytes) {
+			leftover = (struct mblock *) ((unsigned) p + nbytes);
+			q->mnext = leftover;
+			leftover->mnext = p->mnext;
+			leftover->mlen = p->mlen - nbytes;
+			return((WORD *) p);
+		}
+	return((WORD *) SYSERR);
+}
+
+/*------------------------------------------------------------------------
+ * vmb_fffree - return a block to vmb_fflist, merging neighbours (the
+ *              old vfreemem)
+ *------------------------------------------------------------------------
+ */
+LOCAL int vmb_fffree(struct mblock *block, unsigned size)
+{
+	struct	mblock	*p, *q;
+	unsigned top;
+
+	size = (unsigned) roundmb(size);
+	for (p = vmb_fflist.mnext, q = &vmb_fflist; p != NULL && p < block;
+	     q = p, p = p->mnext)
+		;
+	if (((top = q->mlen + (unsigned) q) > (unsigned) block &&
+	    q != &vmb_fflist) ||
+	    (p != NULL && (size + (unsigned) block) > (unsigned) p))
+		return(SYSERR);
+	if (q != &vmb_fflist && top == (unsigned) block)
+		q->mlen += size;
+	else {
+		block->mlen = size;
+		block->mnext = p;
+		q->mnext = block;
+		q = block;
+	}
+	if ((unsigned) (q->mlen + (unsigned) q) == (unsigned) p) {
+		q->mlen += p->mlen;
+		q->mnext = p->mnext;
+	}
+	return(OK);
+}
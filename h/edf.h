@@ -0,0 +1,28 @@
+/* edf.h - isedf */
+
+#ifndef _EDF_H_
+#define _EDF_H_
+
+/* earliest-deadline-first real-time processes (see edf.c)		*/
+
+#define	EDF_MAXUTIL	900		/* admitted budget/period sum,	*/
+					/*  per mille of the CPU	*/
+#define	EDF_NONE	0xffffffffUL	/* edfnext with no EDF process	*/
+
+#define	isedf(pptr)	((pptr)->pperiod > 0)
+
+extern	unsigned long	edfnext;	/* ctr1000 of the next release	*/
+extern	int	edfhead, edftail;	/* ready EDF processes, by	*/
+					/*  absolute deadline		*/
+
+SYSCALL	setedf(int pid, int period, int budget);
+SYSCALL	edfwait(void);
+SYSCALL	edfmisses(int pid);
+void	edf_print(void);
+void	edfinit(void);
+void	edfdrop(int pid);
+void	edfcharge(struct pentry *);
+int	edfadvance(void);
+INTPROC	edfrelease(void);
+
+#endif
@@ -10,5 +10,6 @@
 #define	IMR	(ICU1+1)	/* Interrupt Mask Register		*/
 
 #define	EOI	0x20		/* non-specific end of interrupt	*/
+#define	RDIRR	0x0a		/* OCW3: next OCR read gets the IRR	*/
 
 #endif
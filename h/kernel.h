@@ -69,13 +69,22 @@ typedef short	STATWORD[1];	/* machine status for disable/restore	*/
 				/* by declaring it to be an array, the	*/
 				/* name provides an address so forgotten*/
 				/* &'s don't become a problem		*/
+int	disable(short *ps);
+int	restore(short *ps);
 
 /* Miscellaneous utility inline functions */
 #define	isodd(x)	(01&(WORD)(x))
 #define	min(a,b)	( (a) < (b) ? (a) : (b) )
 #define	max(a,b)	( (a) > (b) ? (a) : (b) )
 
-extern	int	rdyhead, rdytail;
+#define	NRDYPRIO	256		/* ready lists, one per priority */
+#define	MAXPRIO		(NRDYPRIO-1)	/* highest process priority	*/
+
+#define	TW_BITS		6		/* sleep timing wheel: 64 slots	*/
+#define	TW_LEVELS	4		/*  a level, 2^24 ms in all	*/
+#define	NTWSLOT		(TW_LEVELS << TW_BITS)
+
+extern	int	rdyhead;
 extern	int	preempt;
 
 /* Include types and configuration information */
@@ -91,15 +100,19 @@ extern	int	preempt;
 int blkcmp(void *p1, void *p2, int len);
 int blkcopy(void *to, void *from, int len);
 int blkequ(void *p1, void *p2, int len);
+void bzero(void *p, int len);
+unsigned long div64(unsigned long long n, unsigned long d);
 void clkinit();
 int dotrace(char *procname, int *argv, int argc);
 int initevec();
 int kputc(int dev, unsigned char c);
 int main();
 int panic(char *msg);
+void pause(void);
 int ready(int pid, int resch);
 int resched();
 int set_evec(u_int xnum, u_long handler);
+int set_tvec(u_int xnum, u_short tss);
 void trap(int inum);
 int xdone();
 long sizmem();
@@ -117,6 +130,9 @@ SYSCALL getpid();
 SYSCALL getprio(int pid);
 SYSCALL	gettime(long *timvar);
 SYSCALL kill(int pid);
+int kill_reap(int pid);
+SYSCALL mkproc(int *procaddr, int ssize, int priority, char *name,
+	int nargs, unsigned long *argv, int vstk);
 SYSCALL naminit();
 SYSCALL	nammap(char *name, char *newname);
 SYSCALL namopen(struct devsw *devptr, char *filenam, char *mode);
@@ -143,6 +159,8 @@ SYSCALL	sendf(int pid, int msg);
 SYSCALL	setdev(int pid, int dev1, int dev2);
 SYSCALL	setnok(int nok, int pid);
 SYSCALL screate(int count);
+SYSCALL setschedclass(int cls);
+SYSCALL getschedclass(void);
 SYSCALL signal(int sem);
 SYSCALL signaln(int sem, int count);
 SYSCALL	sleep(int n);
@@ -20,10 +20,11 @@
 
 
 /*----------------------------------------------------------------------
- *  freestk  --  free stack memory allocated by getstk
+ *  freestk  --  free stack memory allocated by getstk (it may be kept
+ *		 in the stack cache for the next getstk of that size)
  *----------------------------------------------------------------------
  */
-#define freestk(p,len)	freemem((struct mblock*)((unsigned)(p)	\
+#define freestk(p,len)	stkc_put((struct mblock*)((unsigned)(p)	\
 				- (unsigned)(roundmb(len))	\
 				+ (unsigned)sizeof(int)),	\
 				(int)roundmb(len) )
@@ -32,9 +33,50 @@ struct	mblock	{
 	struct	mblock	*mnext;
 	unsigned int	mlen;
 	};
-extern	struct	mblock	memlist;	/* head of free memory list	*/
+
+/*----------------------------------------------------------------------
+ *  kernel heap (see tlsf.c): counters kept by getmem/freemem and the
+ *  fragmentation figures getmemstat() derives from them
+ *----------------------------------------------------------------------
+ */
+struct	memstat	{
+	unsigned long	ms_free;	/* bytes in free blocks		*/
+	unsigned long	ms_used;	/* bytes in allocated blocks	*/
+	unsigned long	ms_peak;	/* most ever allocated		*/
+	unsigned long	ms_nfree;	/* free blocks			*/
+	unsigned long	ms_nused;	/* allocated blocks		*/
+	unsigned long	ms_largest;	/* largest free block		*/
+	unsigned long	ms_fail;	/* requests that found no block	*/
+	unsigned long	ms_frag;	/* 1000 * (1 - largest / free)	*/
+	};
+
+extern	struct	memstat	memstat;
 extern	char	*maxaddr;		/* max memory address		*/
 extern	WORD	_end;			/* address beyond loaded memory	*/
 extern	WORD	*end;			/* &_end + FILLSIZE		*/
 
+void	tlsf_init(void);
+void	tlsf_addpool(char *, unsigned);
+char	*tlsf_alloc(unsigned);
+char	*tlsf_memalign(unsigned, unsigned);
+int	tlsf_free(char *, unsigned);
+int	getmemstat(struct memstat *);
+void	memstat_print(void);
+int	memreclaim(void);
+
+/*----------------------------------------------------------------------
+ *  stack cache (see stkcache.c): freed stacks kept by size for reuse
+ *----------------------------------------------------------------------
+ */
+#define	NSTKCLASS	8		/* stack sizes cached at once	*/
+#define	STKCACHEN	4		/* default stacks kept per size	*/
+#define	STKCACHEMAX	(256 * 1024)	/* bytes kept, all sizes	*/
+
+char	*stkc_get(unsigned);
+int	stkc_put(struct mblock *, unsigned);
+int	stkc_reclaim(void);
+int	stkc_setcap(int);
+void	stkc_print(void);
+void	stkbench(void);
+
 #endif
@@ -0,0 +1,34 @@
+/* mlfq.h - mlfqprio */
+
+#ifndef _MLFQ_H_
+#define _MLFQ_H_
+
+/* multi-level feedback queue scheduling class (MLFQSCHED)		*/
+
+#define	NMLFQ		8		/* levels; 0 runs first		*/
+#define	MLFQ_BOOST	1000		/* ms between boosts to level 0	*/
+
+/* ready list priority of level l; the null process stays at 0 */
+#define	mlfqprio(l)	(NMLFQ - (l))
+
+struct	mlfqstat	{
+	int	mq_quantum[NMLFQ];	/* clock ticks per quantum	*/
+	int	mq_nproc[NMLFQ];	/* processes at each level now	*/
+	unsigned long	mq_time[NMLFQ];	/* ms run at each level		*/
+	unsigned long	mq_picks[NMLFQ]; /* times picked at each level	*/
+	unsigned long	mq_demote;	/* quanta used up		*/
+	unsigned long	mq_promote;	/* blocked before the quantum	*/
+	unsigned long	mq_boosts;
+	int	mq_boostms;		/* boost period, 0 if off	*/
+	};
+
+SYSCALL	mlfqquantum(int level, int ticks);
+SYSCALL	mlfqboost(int ms);
+SYSCALL	getmlfqstat(struct mlfqstat *);
+void	mlfqstat_print(void);
+void	mlfq_reset(void);
+void	mlfq_charge(struct pentry *, unsigned long);
+int	mlfq_pick(void);
+int	mlfq_quantum(struct pentry *);
+
+#endif
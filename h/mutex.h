@@ -0,0 +1,52 @@
+/* mutex.h - isbadmutex */
+
+#ifndef _MUTEX_H_
+#define _MUTEX_H_
+
+/* priority-inheritance mutexes (see mutex.c)				*/
+
+#ifndef	NMUTEX
+#define	NMUTEX		50	/* number of mutexes, if not defined	*/
+#endif
+
+#define	MFREE	'\01'		/* this mutex is free			*/
+#define	MUSED	'\02'		/* this mutex is used			*/
+
+#define	NOOWNER	BADPID		/* mowner of an unlocked mutex		*/
+
+struct	mentry	{		/* mutex table entry			*/
+	char	mstate;		/* the state MFREE or MUSED		*/
+	int	mowner;		/* pid holding it, or NOOWNER		*/
+	int	mqhead;		/* q index of head of waiters, in	*/
+	int	mqtail;		/*  priority order			*/
+	unsigned long mlocks;	/* mlock() calls that got it		*/
+	unsigned long mwaits;	/*  of those, the ones that waited	*/
+	unsigned long mboosts;	/* times it raised its owner's priority	*/
+	unsigned long mwaitus;	/* us waited, all waiters		*/
+	unsigned long mwaitmax;	/* longest wait, us			*/
+};
+extern	struct	mentry	mutab[];
+
+#define	isbadmutex(m)	((m)<0 || (m)>=NMUTEX)
+
+struct	mstat	{		/* what getmstat() returns		*/
+	int	ms_owner;	/* pid holding it, or NOOWNER		*/
+	int	ms_nwait;	/* processes waiting now		*/
+	unsigned long ms_locks;
+	unsigned long ms_waits;
+	unsigned long ms_boosts;
+	unsigned long ms_waitus;
+	unsigned long ms_waitmax;
+};
+
+SYSCALL	mcreate(void);
+SYSCALL	mdelete(int m);
+SYSCALL	mlock(int m);
+SYSCALL	munlock(int m);
+SYSCALL	getmstat(int m, struct mstat *ms);
+void	mstat_print(void);
+void	minit(void);
+void	minherit(int pid);
+int	mreap(int pid);
+
+#endif
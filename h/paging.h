@@ -49,8 +49,15 @@ typedef struct{
   int bs_npages;			/* number of pages in the store */
   int bs_sem;				/* semaphore mechanism ?	*/
   int bs_pvt_heap;			/* has private heap or not */	
+  int bs_advice;			/* MADV_* hint for the region	*/
+  unsigned long bs_rdonly[8];		/* bit per page: read-only	*/
+  unsigned long bs_zero[8];		/* bit per page: contents dead,	*/
+					/*   fill with zeros on fault	*/
 } bs_map_t;
 
+#define BS_RDONLY(bs, page)	((bs)->bs_rdonly[(page) >> 5] & (1UL << ((page) & 31)))
+#define BS_ZERO(bs, page)	((bs)->bs_zero[(page) >> 5] & (1UL << ((page) & 31)))
+
 typedef struct{
   int fr_status;			/* MAPPED or UNMAPPED		*/
   int fr_pid;				/* process id using this frame  */
@@ -58,26 +65,172 @@ typedef struct{
   int fr_refcnt;			/* reference count		*/
   int fr_type;				/* FR_DIR, FR_TBL, FR_PAGE	*/
   int fr_dirty;
+  int fr_flags;				/* FRF_* flags			*/
+  int fr_next;				/* owner's frame list, or -1	*/
+  int fr_prev;
+  int fr_rmap;				/* first rmap_tab record, or -1	*/
 }fr_map_t;
 
+typedef struct{
+  int rm_pid;				/* process whose table maps it	*/
+  pt_t *rm_pte;				/* the mapping entry		*/
+  int rm_next;				/* next mapper, or -1		*/
+}rmap_t;
+
 typedef struct{
   int frameid;				/* frame id */
   int next;				/* next frame */
   int fr_age;				/* frame age */
+  int prev;				/* previous frame */
 }pr_queue;
 
+/* Private heaps (vcreate).  Pages hold either objects of one power-of-	*/
+/* two size class or part of a multi-page run; the per-page metadata	*/
+/* lives in kernel memory, so vgetmem() never faults just to search.	*/
+/* A heap grows a chunk at a time: each chunk is one backing store of	*/
+/* VH_CHUNKPG pages with its own metadata, attached on first use.	*/
+
+#define VH_CHUNKPG	256		/* pages per chunk (one store)	*/
+#define NVHCHUNK	8		/* chunks per heap at most	*/
+#define VH_MAXPG	(NVHCHUNK * VH_CHUNKPG)
+#define VH_GROW		16		/* pages added per heap growth	*/
+#define VH_MINOBJ	8		/* smallest size class		*/
+#define VH_MAXOBJ	2048		/* larger requests take pages	*/
+#define NVHCLASS	9		/* 8, 16, ... VH_MAXOBJ bytes	*/
+#define VHC_FREE	0xff		/* vc_class: page unused	*/
+#define VHC_RUN		0xfe		/* vc_class: page of a run	*/
+#define VH_NONE		0xffff		/* end of a page's free list	*/
+
+struct vhchunk {
+  int vc_store;				/* backing store behind it	*/
+  int vc_nfreepg;			/* pages in no class or run	*/
+  short vc_next[VH_CHUNKPG];		/* partial list links (heap	*/
+  short vc_prev[VH_CHUNKPG];		/*   page numbers), or -1	*/
+  unsigned char vc_class[VH_CHUNKPG];	/* class, VHC_FREE or VHC_RUN	*/
+  unsigned short vc_nfree[VH_CHUNKPG];	/* free objects in a class page	*/
+  unsigned short vc_flist[VH_CHUNKPG];	/* offset of first freed object	*/
+  unsigned short vc_bump[VH_CHUNKPG];	/* offset of first unused object*/
+  unsigned long vc_pmap[VH_CHUNKPG / 32]; /* bit set: page is free	*/
+};
+
+struct vheap {
+  unsigned long vh_base;		/* address of heap page 0	*/
+  int vh_npages;			/* pages below the break	*/
+  short vh_partial[NVHCLASS];		/* class pages with room, or -1	*/
+  struct vhchunk *vh_chunk[NVHCHUNK];	/* NULL until attached		*/
+};
+
+/* chunk and chunk slot of heap page p */
+#define VH_CHUNK(vh, p)	((vh)->vh_chunk[(p) / VH_CHUNKPG])
+#define VH_SLOT(p)	((p) % VH_CHUNKPG)
+
 extern bs_map_t bsm_tab[];
 extern fr_map_t frm_tab[];
 extern pr_queue pr_qtab[];
+extern rmap_t rmap_tab[];
 
 extern bool debug_option;
 
 extern int pr_qhead;
+extern int pr_qtail;
+
+/* Paging statistics (see vmstat.c).  Latency histograms are log2	*/
+/* buckets of TSC cycles: bucket b counts samples in [2^b, 2^(b+1)).	*/
+
+#define NVMHIST		32		/* buckets per histogram	*/
+
+#define VMH_FAULT	0		/* whole page fault path	*/
+#define VMH_GETFRM	1		/* get_frm()			*/
+#define VMH_POLICY	2		/* pr_policy()			*/
+#define VMH_BSIO	3		/* read_bs() and write_bs()	*/
+#define NVMH		4
+
+#define VMS_ALL		(-1)		/* getvmstat() pid: system-wide */
+
+struct vmstat {
+  unsigned long vs_majflt;		/* faults that read the store	*/
+  unsigned long vs_minflt;		/* faults resolved without I/O	*/
+  unsigned long vs_evict;		/* frames taken by pr_policy()	*/
+  unsigned long vs_wback;		/* pages written back		*/
+  unsigned long vs_prefhit;		/* prefetched pages referenced	*/
+  unsigned long vs_locked;		/* frames pinned by vmlock()	*/
+  unsigned long vs_protflt;		/* writes to read-only pages	*/
+  unsigned long vs_hist[NVMH][NVMHIST];	/* latency histograms		*/
+};
+
+extern struct vmstat vmstat;
+extern int vm_nlocked;
+
+/* Page fault event trace (see pftrace.c).  Records are 32 bytes,	*/
+/* little endian, and are streamed by pftrace_dump() in frames of the	*/
+/* form PFT_FLAG type payload cksum PFT_FLAG, where PFT_FLAG, PFT_ESC	*/
+/* and '\n' inside a frame are sent as PFT_ESC, byte ^ 0x20 and cksum	*/
+/* makes the byte sum of type, payload and cksum zero.			*/
+
+#define NPFTRACE	512		/* records kept in the ring	*/
+
+#define PFT_WBACK	0x1		/* victim was written back	*/
+#define PFT_NEWPT	0x2		/* a page table was allocated	*/
+#define PFT_MAJOR	0x4		/* page read from backing store	*/
+#define PFT_PROT	0x8		/* protection fault, pid killed	*/
+
+#define PFT_FLAG	0x7e		/* frame delimiter		*/
+#define PFT_ESC		0x7d		/* escape for stuffed bytes	*/
+#define PFT_HDR		'H'		/* version, recsize, nrec, lost	*/
+#define PFT_REC		'R'		/* one struct pftrec		*/
+#define PFT_END		'E'		/* end of dump			*/
+#define PFT_VERSION	1
+
+struct pftrec {
+  unsigned long long pt_tsc;		/* TSC at fault entry		*/
+  unsigned long pt_vaddr;		/* faulting address (CR2)	*/
+  unsigned long pt_errcode;		/* page fault error code	*/
+  short pt_pid;				/* faulting process		*/
+  short pt_frame;			/* frame given to the page	*/
+  short pt_vframe;			/* victim frame or -1		*/
+  short pt_vpid;			/* victim owner or -1		*/
+  unsigned long pt_vvpno;		/* victim virtual page number	*/
+  unsigned long pt_flags;		/* PFT_* flags			*/
+};
+
+extern struct pftrec pft_cur;
+extern int pft_enabled;
+extern unsigned long pferrcode;		/* set by pfintr		*/
+extern unsigned long pfrsvstk[];	/* stack of a process being killed */
+
+/* Paging locks (see pglock.c).  While any is held, and while the page	*/
+/* fault task runs (pfbusy), resched() defers the switch to pgresched.	*/
+
+#define PGL_FRM		0		/* frames, page tables, rmap	*/
+#define PGL_PRQ		1		/* replacement queue		*/
+#define PGL_BSM		2		/* bsm_tab and the stores	*/
+#define NPGLOCK		3
+
+struct pglentry {
+  int pl_depth;				/* held this many times, nested	*/
+  int pl_fault;				/* taken by the page fault task	*/
+  unsigned long pl_acquires;		/* outermost takes		*/
+  unsigned long pl_maxhold;		/* longest hold, TSC cycles	*/
+  unsigned long long pl_t0;		/* TSC when taken		*/
+};
 
+extern struct pglentry pglocks[];
+extern int pgnopreempt;			/* locks held			*/
+extern int pgresched;			/* a switch waits for them	*/
+extern int pfbusy;			/* set by pfintr		*/
 
 /* Prototypes for required API calls */
 SYSCALL xmmap(int, bsd_t, int);
-SYSCALL xunmap(int);
+SYSCALL xmmap_prot(int, bsd_t, int, int);
+SYSCALL xmunmap(int);
+SYSCALL xmprotect(int, int, int);
+SYSCALL vmprotect(unsigned long, unsigned long, int);
+SYSCALL xmadvise(int, int, int);
+SYSCALL vmlock(unsigned long, unsigned long);
+SYSCALL vmunlock(unsigned long, unsigned long);
+SYSCALL srpolicy(int);
+SYSCALL grpolicy(void);
+SYSCALL vcreate(int *, int, int, int, char *, int, long);
 
 /* given calls for dealing with backing store */
 
@@ -89,6 +242,71 @@ SYSCALL release_bs(bsd_t);
 SYSCALL read_bs(char *, bsd_t, int);
 SYSCALL write_bs(char *, bsd_t, int);
 
+SYSCALL get_frm(int *);
+SYSCALL free_frm(int);
+SYSCALL drop_frm(int);
+void frm_link(int, int);
+void frm_unlink(int);
+void release_frms(int, int);
+void rmap_init(void);
+int rmap_add(int, int, pt_t *);
+int rmap_refd(int, int);
+int rmap_dirty(int, int);
+int rmap_unmap(int);
+void remove_pr_queue(int);
+SYSCALL get_bsm(int *);
+SYSCALL free_bsm(int);
+SYSCALL bsm_map(int, int, int, int);
+SYSCALL bsm_unmap(int, int, int);
+SYSCALL bsm_lookup(int, long, int *, int *);
+void bsm_protect(int, int, int, int);
+void bsm_zero(int, int, int, int);
+void bsm_release(int);
+void pfinit(void);
+void pfintr(void);
+void fpuintr(void);
+int vstk_map(int, unsigned long);
+int vstk_grow(int, unsigned long);
+void vstk_exit(int);
+void handle_page_directory(pd_t *);
+int handle_page_table(pt_t *, unsigned long);
+int prefetch_page(unsigned long);
+
+unsigned long read_cr2(void);
+void write_cr3(unsigned long);
+unsigned long long read_tsc(void);
+
+void vmhist_add(int, unsigned long long);
+SYSCALL getvmstat(int, struct vmstat *);
+SYSCALL clrvmstat(void);
+void vmstat_print(void);
+
+SYSCALL pftrace(int);
+SYSCALL pftrace_clear(void);
+SYSCALL pftrace_dump(void);
+void pftrace_log(void);
+
+void pglock(int);
+void pgunlock(int);
+void pglock_print(void);
+
+WORD *vgetmem(unsigned);
+SYSCALL vfreemem(struct mblock *, unsigned);
+WORD *vsbrk(int);
+SYSCALL vtrim(void);
+void vheap_init(struct vheap *, unsigned long);
+int vh_grow(int, int);
+int vh_shrink(int, int);
+void vheap_free(struct vheap *);
+int vh_sizeclass(unsigned);
+int vh_pgalloc(int, int);
+void vh_pgfree(struct vheap *, int, int);
+void vh_discard(int, int, int);
+int vh_pinned(int, int);
+
+void pgbench(void);
+void vmbench(void);
+
 #define NBPG		4096	/* number of bytes per page	*/
 #define FRAME0		1024	/* zero-th frame		*/
 #define NFRAMES 	1024	/* number of frames		*/
@@ -106,5 +324,57 @@ SYSCALL write_bs(char *, bsd_t, int);
 #define SC 3
 #define AGING 4
 
+/* xmadvise() hints; SEQUENTIAL and RANDOM (and NORMAL) stay with the	*/
+/* region, WILLNEED and DONTNEED act on the given pages immediately.	*/
+
+#define MADV_NORMAL	0		/* no read-ahead		*/
+#define MADV_SEQUENTIAL	1		/* read ahead, drop behind	*/
+#define MADV_RANDOM	2		/* no read-ahead		*/
+#define MADV_WILLNEED	3		/* prefetch the pages now	*/
+#define MADV_DONTNEED	4		/* discard the pages' frames	*/
+
+#define NREADAHEAD	8		/* pages read ahead on a fault	*/
+
+/* Page protection for xmmap_prot(), xmprotect() and vmprotect().  The	*/
+/* MMU cannot hide a present page, so PROT_READ alone means read-only.	*/
+
+#define PROT_READ	0x1
+#define PROT_WRITE	0x2
+#define PROT_RW		(PROT_READ | PROT_WRITE)
+
+/* Page fault error code bits, as pushed by the CPU into pferrcode */
+
+#define PFE_PRES	0x1		/* 0 not present, 1 protection	*/
+#define PFE_WRITE	0x2		/* faulting access was a write	*/
+#define PFE_USER	0x4		/* fault was taken in user mode	*/
+
+#define FRF_PREF	0x1		/* prefetched, not yet referenced */
+#define FRF_SEQ		0x2		/* in a MADV_SEQUENTIAL region	*/
+#define FRF_LOCK	0x4		/* pinned by vmlock()		*/
+#define FRF_NEWLK	0x8		/* pinned by the vmlock() under way */
+
+/* Virtual stacks (vcreate() with VSTACK ORed into hsize): the stack	*/
+/* ends at the top of the address space, in the last page table, and	*/
+/* gets a zero-filled frame per page on first touch.  Stack frames are	*/
+/* never evicted.  The page below the reserve is left unmapped.		*/
+
+#define VSTACK		0x40000000	/* vcreate() hsize flag		*/
+#define VSTK_BASE	0xffc00000	/* region of the last page table */
+#define VSTK_TOPPG	0x100000	/* page just above the stack	*/
+#define VSTK_SP		0xfffffffc	/* first stack word		*/
+#define VSTK_MAXPG	1023		/* reserve, leaving a guard page */
+
+#define NRSVSTK		2048		/* words of the reserve stack	*/
+
+/* vmlock() caps: pinned frames are off the replacement queue, so the	*/
+/* pager must be left enough frames to run.				*/
+
+#define NLOCKPROC	64		/* frames one process may lock	*/
+#define NLOCKSYS	(NFRAMES / 4)	/* frames locked system-wide	*/
+
+/* reverse map: one record per PTE mapping a page frame		*/
+
+#define NRMAP		(2 * NFRAMES)	/* mapping records		*/
+
 #define BACKING_STORE_BASE	0x00800000
 #define BACKING_STORE_UNIT_SIZE 0x00100000
\ No newline at end of file
@@ -27,11 +27,17 @@
 #define	PRSUSP		'\006'		/* process is suspended		*/
 #define	PRWAIT		'\007'		/* process is on semaphore queue*/
 #define	PRTRECV		'\010'		/* process is timing a receive	*/
+#define	PRPERIOD	'\011'		/* EDF, waiting for next period	*/
+#define	PRMUTEX		'\012'		/* process is on a mutex queue	*/
 
-/* process rescheduleing policy */
+/* process rescheduleing policy (scheduling class, see sched.c) */
 
+#define PRIOSCHED               0
 #define RANDOMSCHED             1
 #define PROPORTIONALSHARE       2
+#define MLFQSCHED               3
+
+#define STRIDE1                 65536   /* stride of priority 1         */
 
 /* miscellaneous process definitions */
 
@@ -68,15 +74,38 @@ struct	pentry	{
 
 /* for process scheduling*/
         int     ppolicy;                /* process scheduling policy    */
-        int     ppi;                    /* priority value in psp        */
-        int     prate;                  /* rate value in psp            */
+        unsigned long ppi;              /* pass value in psp            */
+        int     prate;                  /* stride in psp, STRIDE1/pprio */
+        int     plevel;                 /* level in MLFQSCHED           */
+        int     pqleft;                 /* ticks left there, 0: all     */
+        int     pperiod;                /* EDF period in ms, 0: not EDF */
+        int     pbudget;                /* EDF ms per period            */
+        int     pleft;                  /* ms of it left this period    */
+        unsigned long pdeadline;        /* ctr1000 this period ends     */
+        Bool    pdone;                  /* edfwait() called this period */
+        unsigned long pmisses;          /* EDF deadlines missed         */
+        int     putil;                  /* admitted share, per mille    */
+        int     pbprio;                 /* own priority; pprio can be   */
+                                        /*  higher, lent by mutex waiters */
+        int     pmutex;                 /* mutex waited for, or -1      */
+        unsigned long long pmwait;      /* gettime_ns() it began waiting */
 
 /* for demand paging */
         unsigned long pdbr;             /* PDBR                         */
         int     store;                  /* backing store for vheap      */
         int     vhpno;                  /* starting pageno for vheap    */
         int     vhpnpages;              /* vheap size                   */
-        struct mblock *vmemlist;        /* vheap list              	*/
+        struct vheap *vheap;            /* vheap allocator state        */
+        int     pvstk;                  /* virtual stack pages, or 0    */
+
+/* paging statistics, see getvmstat() */
+        unsigned long pmajflt;          /* faults that read the store   */
+        unsigned long pminflt;          /* faults resolved without I/O  */
+        unsigned long pevict;           /* own frames taken by policy   */
+        unsigned long pwback;           /* own pages written back       */
+        unsigned long pprefhit;         /* prefetched pages referenced  */
+        int     plocked;                /* frames pinned by vmlock()    */
+        int     pfrhead;                /* first frame owned, or -1     */
 };
 
 
@@ -84,5 +113,14 @@ extern	struct	pentry proctab[];
 extern	int	numproc;		/* currently active processes	*/
 extern	int	nextproc;		/* search point for free slot	*/
 extern	int	currpid;		/* currently executing process	*/
+extern	int	schedclass;		/* PRIOSCHED, RANDOMSCHED, ...	*/
+
+int schinsert(int pid);
+int schremove(int pid);
+int schpick(void);
+int schkeep(struct pentry *pptr);
+void schcharge(struct pentry *pptr);
+int schquantum(struct pentry *pptr);
+int schalone(void);
 
 #endif
\ No newline at end of file
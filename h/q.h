@@ -1,4 +1,4 @@
-/* q.h - firstid, firstkey, isempty, lastkey, nonempty */
+/* q.h - firstid, firstkey, isempty, lastkey, nonempty, rdyq */
 
 #ifndef _QUEUE_H_
 #define _QUEUE_H_
@@ -6,7 +6,9 @@
 /* q structure declarations, constants, and inline procedures		*/
 
 #ifndef	NQENT
-#define	NQENT		NPROC + NSEM + NSEM + 4	/* for ready & sleep	*/
+#define	NQENT		NPROC + NSEM + NSEM + NRDYPRIO + NRDYPRIO + \
+			NTWSLOT + NTWSLOT + NMUTEX + NMUTEX + 4
+						/* for ready & sleep	*/
 #endif
 
 struct	qent	{		/* one for each process plus two for	*/
@@ -26,6 +28,7 @@ extern	int	nextqueue;
 #define	firstkey(list)	(q[q[(list)].qnext].qkey)
 #define lastkey(tail)	(q[q[(tail)].qprev].qkey)
 #define firstid(list)	(q[(list)].qnext)
+#define	rdyq(prio)	(rdyhead + 2 * (prio))	/* ready list head	*/
 
 /* gpq constants */
 
@@ -42,5 +45,13 @@ int insertd(int pid, int head, int key);
 int insert(int proc, int head, int key);
 int getfirst(int head);
 int getlast(int tail);
+void rdyinit(void);
+int rdyinsert(int pid, int prio);
+int rdyremove(int pid);
+int rdyget(void);
+int rdymax(void);
+int rdydraw(unsigned long ticket);
+
+extern	unsigned long	rdytickets;
 
 #endif
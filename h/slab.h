@@ -0,0 +1,68 @@
+/* slab.h - kmem_cache_create, kmem_cache_alloc, kmem_cache_free */
+
+#ifndef _SLAB_H_
+#define _SLAB_H_
+
+#ifndef	NKMCACHE
+#define	NKMCACHE	16		/* maximum number of caches	*/
+#endif
+#define	KM_LINE		64		/* cache line; default alignment */
+#define	KM_NAMELEN	12		/* cache name, with its NUL	*/
+#define	KM_MINOBJ	4		/* objects per slab at least	*/
+#define	KM_MINSLAB	4096		/* smallest slab (power of 2)	*/
+#define	KM_MAXSLAB	65536		/* largest slab			*/
+
+/*
+ * A cache hands out objects of one size from slabs: naturally aligned
+ * blocks of the kernel heap holding a header, a stack of free object
+ * indices and the objects themselves.  The free stack lives outside the
+ * objects, so an object keeps the state its constructor gave it while
+ * it is free.  Each slab is on one of three lists by how many of its
+ * objects are in use.
+ */
+struct	kmslab	{
+	struct	kmslab	*sl_next;	/* slab list links		*/
+	struct	kmslab	*sl_prev;
+	char	*sl_base;		/* object 0			*/
+	int	sl_inuse;		/* objects handed out		*/
+	int	sl_nfree;		/* entries on sl_free[]		*/
+	unsigned short	sl_free[1];	/* free object indices (nobj)	*/
+	};
+
+struct	kmcache	{			/* one entry per cache		*/
+	char	kc_name[KM_NAMELEN];
+	int	kc_state;		/* KMC_FREE or KMC_USED		*/
+	unsigned	kc_size;	/* object stride (aligned size)	*/
+	unsigned	kc_align;
+	unsigned	kc_slabsize;	/* bytes per slab (power of 2)	*/
+	int	kc_nobj;		/* objects per slab		*/
+	void	(*kc_ctor)(void *);	/* run once per object, or NULL	*/
+	struct	kmslab	*kc_partial;	/* some objects free		*/
+	struct	kmslab	*kc_full;	/* no objects free		*/
+	struct	kmslab	*kc_empty;	/* no objects in use		*/
+	unsigned long	kc_inuse;	/* objects handed out		*/
+	unsigned long	kc_peak;	/* most ever handed out		*/
+	unsigned long	kc_nslabs;
+	unsigned long	kc_allocs;
+	unsigned long	kc_frees;
+	unsigned long	kc_grows;	/* slabs taken from the heap	*/
+	unsigned long	kc_reaps;	/* empty slabs given back	*/
+	unsigned long	kc_fails;	/* allocations that failed	*/
+	};
+
+#define	KMC_FREE	0
+#define	KMC_USED	1
+
+#define	isbadkmc(c)	((c) < 0 || (c) >= NKMCACHE)
+
+extern	struct	kmcache	kmctab[];
+
+int	kmem_cache_create(char *, unsigned, unsigned, void (*)(void *));
+int	kmem_cache_destroy(int);
+void	*kmem_cache_alloc(int);
+int	kmem_cache_free(int, void *);
+int	kmem_cache_reap(int);
+int	kmem_reap(void);
+void	kmem_print(void);
+
+#endif
@@ -3,19 +3,61 @@
 #ifndef _SLEEP_H_
 #define _SLEEP_H_
 
+/* Intel 8254-2 clock chip constants */
+
+#define	CLOCKBASE	0x40		/* I/O base port of clock chip	*/
+#define	CLOCK0		CLOCKBASE
+#define	CLKCNTL		(CLOCKBASE+3)	/* chip CSW I/O port		*/
+#define	CLKCOUNTS	1190		/* counts per 1 ms tick		*/
+#define	CLKMAXSHOT	55		/* longest one-shot, ms		*/
 
 extern	int	clkruns;	/* 1 iff clock exists; 0 otherwise	*/
 				/* Set at system startup.		*/
-extern	int	clockq;		/* q index of sleeping process list	*/
 extern	int	count6;		/* used to ignore 5 of 6 interrupts	*/
 extern	int	count10;	/* used to ignore 9 of 10 ticks		*/
 extern	unsigned long clktime;	/* current time in secs since 1/1/70	*/
+extern	unsigned long ctr1000;	/* milliseconds since clkinit()		*/
 extern	int	clmutex;	/* mutual exclusion sem. for clock	*/
-extern	int	*sltop;		/* address of first key on clockq	*/
-extern	int	slnempty;	/* 1 iff clockq is nonempty		*/
+extern	int	slnempty;	/* sleeping processes, 0 if none	*/
 
 extern	int	defclk;		/* >0 iff clock interrupts are deferred	*/
 extern	int	clkdiff;	/* number of clock clicks deferred	*/
 extern	int	clkint();	/* clock interrupt handler		*/
+extern	unsigned short	count1000;	/* ms to the next clktime second */
+
+/* tickless clock (see tickless.c) */
+
+#define	CLK_PERIODIC	0		/* clkshot: 1 ms ticks		*/
+#define	CLK_STOPPED	(-1)		/*  one-shot over, not rearmed	*/
+#define	CLK_ONESHOT	1		/*  one-shot running		*/
+
+extern	int	clkshot;
+extern	unsigned long	clkints;	/* clock interrupts taken	*/
+
+SYSCALL	settickless(int on);
+void	clkstat_print(void);
+void	clksync(void);
+void	clkarm(void);
+INTPROC	clkexpire(void);
+unsigned long	clkread(void);
+
+/* sleeping processes wait on a hierarchical timing wheel (see wheel.c) */
+
+#define	TW_SLOTS	(1 << TW_BITS)
+#define	TW_MASK		(TW_SLOTS - 1)
+#define	TW_RANGE	(1UL << (TW_BITS * TW_LEVELS))	/* ms the wheel spans */
+
+/* q list head of slot s of level l */
+#define	twslot(l, s)	(twhead + 2 * (((l) << TW_BITS) + (s)))
+
+extern	int	twhead;		/* first slot's list head		*/
+extern	unsigned long	twnow;	/* wheel time, ms			*/
+
+void	twinit(void);
+void	twinsert(int pid, unsigned long ms);
+void	twremove(int pid);
+int	twadvance(unsigned long ticks);
+unsigned long	twnext(void);
+void	slpbench(void);
 
 #endif
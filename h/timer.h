@@ -0,0 +1,58 @@
+/* timer.h - isbadtm */
+
+#ifndef _TIMER_H_
+#define _TIMER_H_
+
+/* TSC clock and microsecond one-shot timers (see tsc.c and timer.c)	*/
+
+#define	PIT_HZ		1193182UL	/* 8254 input clock, Hz		*/
+#define	TSC_SHIFT	24		/* tscmult is ns per cycle << 24 */
+
+#ifndef	NTIMER
+#define	NTIMER		16		/* timers for tmcreate()	*/
+#endif
+
+/* a timer is a callback run from the clock interrupt, with interrupts	*/
+/*  disabled, once its time comes; it must not block			*/
+
+#define	TM_FREE		'\01'		/* timer slot is free		*/
+#define	TM_IDLE		'\02'		/* allocated, not set		*/
+#define	TM_SET		'\03'		/* waiting to fire		*/
+
+#define	TM_NONE		(-1)		/* end of the list of set timers */
+#define	TM_NEVER	0xffffffffffffffffULL	/* no timer is set	*/
+
+struct	tmentry	{
+	char	tmstate;		/* TM_FREE, TM_IDLE or TM_SET	*/
+	int	tmnext;			/* next set timer, by time	*/
+	unsigned long long tmwhen;	/* gettime_ns() it fires at	*/
+	void	(*tmfunc)(int);		/* what it calls, and with	*/
+	int	tmarg;
+};
+
+/* slots 0 to NPROC-1 are each process's own, for sleepus()		*/
+#define	isbadtm(t)	((t) < NPROC || (t) >= NPROC + NTIMER)
+
+extern	struct	tmentry	tmtab[];
+extern	int	tmcount;		/* timers set			*/
+extern	unsigned long	tsckhz;		/* TSC rate, 0 if uncalibrated	*/
+extern	unsigned long	tscmult;	/* ns per TSC cycle << TSC_SHIFT */
+
+void	tscinit(void);
+unsigned long long	gettime_ns(void);
+unsigned long long	tsc2ns(unsigned long long cycles);
+
+void	tminit(void);
+SYSCALL	tmcreate(void (*func)(int), int arg);
+SYSCALL	tmstart(int tm, unsigned long us);
+SYSCALL	tmcancel(int tm);
+SYSCALL	tmdelete(int tm);
+SYSCALL	sleepus(unsigned long us);
+void	tminsert(int t, unsigned long long when);
+void	tmremove(int t);
+unsigned long long	tmdue(void);
+unsigned long	tmcounts(void);
+int	tmexpire(void);
+void	tmbench(void);
+
+#endif
@@ -32,7 +32,7 @@ int monitor(u_short csr)
     int i = 0;
     unsigned char ch = 0, str[MON_MAXSTR+1];
 
-    kprintf("monitor commands: <?> help, <b> boot Xinu, <c> continue, <r> restart\n");
+    kprintf("monitor commands: <?> help, <b> boot Xinu, <c> continue, <r> restart, <v> vmstat\n");
     kprintf("%s", MON_PROMPT);
     
     while (1) {
@@ -95,6 +95,7 @@ int mon_cmd(char *str)
     short old_girmask;
     extern int   mon_clkint();	/* clock int. handler, for retx purpose */
     extern int   clkint();
+    extern void  vmstat_print();
     
 #ifdef DEBUG
     kprintf("mon_cmd = [%s]\n", str);
@@ -130,6 +131,10 @@ int mon_cmd(char *str)
     else if (strcmp(str, "r") == 0) {
 	start();
     }
+    else if (strcmp(str, "v") == 0) {
+	vmstat_print();
+	kprintf("%s", MON_PROMPT);
+    }
     else if ((strcmp(str, "h") == 0) || (strcmp(str, "?") == 0) ||
 	(strcmp(str, "help") == 0)) {
 	mon_help();
@@ -154,6 +159,7 @@ int mon_help()
     kprintf("b\tboot Xinu from network\n");
     kprintf("c\tcontinue execution\n");
     kprintf("r\trestart Xinu\n");
+    kprintf("v\tpaging statistics\n");
     kprintf("---------------------------------\n\n");
     return(OK);
 }
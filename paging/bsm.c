@@ -9,24 +9,26 @@
  */
 SYSCALL backing_store_map()
 {
-    STATWORD ps;
-    disable(ps);
+    pglock(PGL_BSM);
 
     int id;
 
     for(id = 0; id < 8; id++){
 
-        bs_map_t bs_num = bsm_tab[id];
-        bs_num.bs_status = BSM_UNMAPPED;
-        bs_num.bs_pid = -1;
-        bs_num.bs_vpno = 4096;
-        bs_num.bs_npages = 0;
-        bs_num.bs_sem = 0;
-        bs_num.bs_pvt_heap = 0;
+        bs_map_t *bs_num = &bsm_tab[id];
+        bs_num->bs_status = BSM_UNMAPPED;
+        bs_num->bs_pid = -1;
+        bs_num->bs_vpno = 4096;
+        bs_num->bs_npages = 0;
+        bs_num->bs_sem = 0;
+        bs_num->bs_pvt_heap = 0;
+        bs_num->bs_advice = MADV_NORMAL;
+        bsm_protect(id, 0, 256, PROT_RW);
+        bsm_zero(id, 0, 256, 0);
 
     }
 
-    restore(ps);
+    pgunlock(PGL_BSM);
     return OK;
 			
 }
@@ -37,20 +39,19 @@ SYSCALL backing_store_map()
  */
 SYSCALL get_bsm(int* avail)
 {
-    STATWORD ps;
-    disable(ps);
+    pglock(PGL_BSM);
 
     int id;
 
     for(id = 0; id < 8; id++){
         if(bsm_tab[id].bs_status == BSM_UNMAPPED){
             *avail = id;
-            restore(ps);
+            pgunlock(PGL_BSM);
             return OK;
         }
     }
     kprintf("Backing Store Unavailable");
-    restore(ps);
+    pgunlock(PGL_BSM);
     return SYSERR;
 	
 }
@@ -62,33 +63,35 @@ SYSCALL get_bsm(int* avail)
  */
 SYSCALL free_bsm(int i)
 {
-    STATWORD ps;
-    disable(ps);
+    pglock(PGL_BSM);
 
     if(i < 0 || i >= 8){
-        restore(ps);
+        pgunlock(PGL_BSM);
         return SYSERR;
     }
 
     if(bsm_tab[i].bs_status == BSM_UNMAPPED){
-        restore(ps);
+        pgunlock(PGL_BSM);
         return SYSERR;
     }
 
     if(bsm_tab[i].bs_pid != currpid){
-        restore(ps);
+        pgunlock(PGL_BSM);
         return SYSERR;
     }
 
-    bs_map_t bs_num = bsm_tab[i];
-    bs_num.bs_status = BSM_UNMAPPED;
-    bs_num.bs_pid = -1;
-    bs_num.bs_vpno = 4096;
-    bs_num.bs_npages = 0;
-    bs_num.bs_sem = 0;
-    bs_num.bs_pvt_heap = 0;
-
-    restore(ps);
+    bs_map_t *bs_num = &bsm_tab[i];
+    bs_num->bs_status = BSM_UNMAPPED;
+    bs_num->bs_pid = -1;
+    bs_num->bs_vpno = 4096;
+    bs_num->bs_npages = 0;
+    bs_num->bs_sem = 0;
+    bs_num->bs_pvt_heap = 0;
+    bs_num->bs_advice = MADV_NORMAL;
+    bsm_protect(i, 0, 256, PROT_RW);
+    bsm_zero(i, 0, 256, 0);
+
+    pgunlock(PGL_BSM);
     return OK;
 	
 }
@@ -99,11 +102,10 @@ SYSCALL free_bsm(int i)
  */
 SYSCALL bsm_lookup(int pid, long vaddr, int* store, int* pageth)
 {
-	STATWORD 	ps;
-	disable(ps);
+	pglock(PGL_BSM);
 
     if (pid <= 0 || pid >= NPROC){
-        restore(ps);
+        pgunlock(PGL_BSM);
         return SYSERR;
     }
 
@@ -132,20 +134,20 @@ SYSCALL bsm_lookup(int pid, long vaddr, int* store, int* pageth)
     int id;
     for(id = 0; id < 8; id++){
 
-        bs_map_t bs_num = bsm_tab[id];
+        bs_map_t *bs_num = &bsm_tab[id];
 
-        if( bs_num.bs_status == BSM_MAPPED && bs_num.bs_pid == pid){
+        if( bs_num->bs_status == BSM_MAPPED && bs_num->bs_pid == pid){
 
-            if( vpno >= bs_num.bs_vpno){
+            if( vpno >= bs_num->bs_vpno && vpno < bs_num->bs_vpno + bs_num->bs_npages){
                 *store = id;
-                *pageth = vpno - bs_num.bs_vpno; 
-                restore(ps); 
+                *pageth = vpno - bs_num->bs_vpno; 
+                pgunlock(PGL_BSM); 
 			    return OK;
             }
 		}				
 	}
 	
-	restore(ps);
+	pgunlock(PGL_BSM);
 	return SYSERR;
 	
 }
@@ -157,39 +159,39 @@ SYSCALL bsm_lookup(int pid, long vaddr, int* store, int* pageth)
  */
 SYSCALL bsm_map(int pid, int vpno, int source, int npages)
 {
-    STATWORD ps;
-    disable(ps);
+    pglock(PGL_BSM);
 
     if(source < 0 || source > 7){
-        restore(ps);
+        pgunlock(PGL_BSM);
         return SYSERR;
     }
 
     if (pid <= 0 || pid >= NPROC){
-        restore(ps);
+        pgunlock(PGL_BSM);
         return SYSERR;
     }
 
-    bs_map_t bs_num = bsm_tab[source];
+    bs_map_t *bs_num = &bsm_tab[source];
 
-    if (bs_num.bs_pid != pid && bs_num.bs_pvt_heap == 1){
-        restore(ps);
+    if (bs_num->bs_pid != pid && bs_num->bs_pvt_heap == 1){
+        pgunlock(PGL_BSM);
         return SYSERR;
     }
 
     else{
-		bs_num.bs_status = BSM_MAPPED;
-		bs_num.bs_pid = pid;
-		bs_num.bs_vpno = vpno;
-		bs_num.bs_npages = npages;
-		proctab[currpid].vhpno = vpno;
-		proctab[currpid].store = source;
+		bs_num->bs_status = BSM_MAPPED;
+		bs_num->bs_pid = pid;
+		bs_num->bs_vpno = vpno;
+		bs_num->bs_npages = npages;
+		bs_num->bs_advice = MADV_NORMAL;
+		bsm_protect(source, 0, 256, PROT_RW);
+		bsm_zero(source, 0, 256, 0);
 	
-		restore(ps);
+		pgunlock(PGL_BSM);
 		return(OK);
     }
 
-    restore(ps);
+    pgunlock(PGL_BSM);
     return SYSERR;
 }
 
@@ -201,35 +203,98 @@ SYSCALL bsm_map(int pid, int vpno, int source, int npages)
  */
 SYSCALL bsm_unmap(int pid, int vpno, int flag)
 {
-	STATWORD 	ps;
-	disable(ps);
+	pglock(PGL_BSM);
 	
 	int bs_id;
 	int pageth;
-    int mapping_found = 0;
-	int i;
-
-	for (i = 0; i < NFRAMES; i++)
-	{
-		if (frm_tab[i].fr_status == FRM_MAPPED && frm_tab[i].fr_pid == pid && frm_tab[i].fr_type == FR_PAGE)
-		{
-            bsm_lookup(pid, vpno*NBPG, &bs_id, &pageth);
-			write_bs((i + NFRAMES) * NBPG, bs_id, pageth);
-            mapping_found = 1;
-			break;	
-		}				
-	}
 
-    if (mapping_found == 1){
-        bs_map_t bs_num = bsm_tab[bs_id]; 
-        bs_num.bs_status = BSM_UNMAPPED;
-        bs_num.bs_pid = -1;
-        bs_num.bs_vpno = 4096;
-        bs_num.bs_npages = 0;
-        bs_num.bs_pvt_heap = 0;
+    if (bsm_lookup(pid, vpno*NBPG, &bs_id, &pageth) == SYSERR) {
+        pgunlock(PGL_BSM);
+        return SYSERR;
     }
 
-    restore(ps);
+    // Write back and free every frame the process holds of this store
+    release_frms(pid, bs_id);
+
+    bs_map_t *bs_num = &bsm_tab[bs_id]; 
+    bs_num->bs_status = BSM_UNMAPPED;
+    bs_num->bs_pid = -1;
+    bs_num->bs_vpno = 4096;
+    bs_num->bs_npages = 0;
+    bs_num->bs_pvt_heap = 0;
+    bs_num->bs_advice = MADV_NORMAL;
+    bsm_protect(bs_id, 0, 256, PROT_RW);
+    bsm_zero(bs_id, 0, 256, 0);
+
+    pgunlock(PGL_BSM);
 	return(OK);	
 			
 }
+
+/*-------------------------------------------------------------------------
+ * bsm_release - drop every bsm_tab entry of pid (the process is gone and
+ *               its frames have been released)
+ *-------------------------------------------------------------------------
+ */
+void bsm_release(int pid)
+{
+    pglock(PGL_BSM);
+
+    int i;
+    for (i = 0; i < 8; i++) {
+        bs_map_t *bs_num = &bsm_tab[i];
+        if (bs_num->bs_status == BSM_UNMAPPED || bs_num->bs_pid != pid) {
+            continue;
+        }
+        bs_num->bs_status = BSM_UNMAPPED;
+        bs_num->bs_pid = -1;
+        bs_num->bs_vpno = 4096;
+        bs_num->bs_npages = 0;
+        bs_num->bs_sem = 0;
+        bs_num->bs_pvt_heap = 0;
+        bs_num->bs_advice = MADV_NORMAL;
+        bsm_protect(i, 0, 256, PROT_RW);
+        bsm_zero(i, 0, 256, 0);
+    }
+
+    pgunlock(PGL_BSM);
+}
+
+/*-------------------------------------------------------------------------
+ * bsm_protect - make npages pages of store from page first read-only
+ *               (prot lacks PROT_WRITE) or writable
+ *-------------------------------------------------------------------------
+ */
+void bsm_protect(int store, int first, int npages, int prot)
+{
+    bs_map_t *bs_num = &bsm_tab[store];
+    int page;
+
+    for (page = first; page < first + npages && page < 256; page++) {
+        if (prot & PROT_WRITE) {
+            bs_num->bs_rdonly[page >> 5] &= ~(1UL << (page & 31));
+        } else {
+            bs_num->bs_rdonly[page >> 5] |= 1UL << (page & 31);
+        }
+    }
+}
+
+/*-------------------------------------------------------------------------
+ * bsm_zero - mark npages pages of store from page first as holding dead
+ *            data (zero set), so the next fault on one of them zero-fills
+ *            the frame instead of reading the store, or clear the mark
+ *-------------------------------------------------------------------------
+ */
+void bsm_zero(int store, int first, int npages, int zero)
+{
+    bs_map_t *bs_num = &bsm_tab[store];
+    int page;
+
+    for (page = first; page < first + npages && page < 256; page++) {
+        if (zero) {
+            bs_num->bs_zero[page >> 5] |= 1UL << (page & 31);
+        } else {
+            bs_num->bs_zero[page >> 5] &= ~(1UL << (page & 31));
+        }
+    }
+}
@@ -1,5 +1,5 @@
 /* control_reg.c - read_cr0 read_cr2 read_cr3 read_cr4
-		   write_cr0 write_cr3 write_cr4 enable_pagine */
+		   write_cr0 write_cr3 write_cr4 enable_pagine read_tsc */
 
 #include <conf.h>
 #include <kernel.h>
@@ -183,8 +183,20 @@ void write_cr4(unsigned long n) {
 void enable_paging(){
   
   unsigned long temp =  read_cr0();
-  temp = temp | ( 0x1 << 31 ) | 0x1;
+  temp = temp | ( 0x1 << 31 ) | ( 0x1 << 16 ) | 0x1;	/* PG, WP (ring 0 honors read-only pages), PE */
   write_cr0(temp); 
 }
 
 
+/*-------------------------------------------------------------------------
+ * read_tsc - read the time stamp counter
+ *-------------------------------------------------------------------------
+ */
+unsigned long long read_tsc(void) {
+
+  unsigned long long tsc;
+
+  asm volatile("rdtsc" : "=A" (tsc));
+
+  return tsc;
+}
@@ -20,7 +20,10 @@ struct FrameInitValues {
     int fr_refcnt;  // Reference count indicating the number of references to the frame
     int fr_type;    // Type of the frame (e.g., PAGE, TABLE)
     int fr_dirty;   // Flag indicating whether the frame has been modified
-
+    int fr_flags;   // FRF_* flags (prefetched, sequential region)
+    int fr_next;    // Next frame of the owner's frame list
+    int fr_prev;    // Previous frame of the owner's frame list
+    int fr_rmap;    // First reverse-map record of the frame's mappers
 };
 
 /* Function: init_frm
@@ -33,8 +36,7 @@ struct FrameInitValues {
 */
 
 SYSCALL frame_table_map() {
-    STATWORD ps;
-    disable(ps);
+    pglock(PGL_FRM);
 
     // Define initialization values for frm_tab
     struct FrameInitValues initValues = {
@@ -43,7 +45,11 @@ SYSCALL frame_table_map() {
         .fr_vpno = 0,               // Initial virtual page number is set to 0
         .fr_refcnt = 0,             // Initial reference count is set to 0
         .fr_type = FR_PAGE,         // Initial frame type is set to PAGE
-        .fr_dirty = 0               // Initial dirty flag is set to 0
+        .fr_dirty = 0,              // Initial dirty flag is set to 0
+        .fr_flags = 0,              // No prefetch or advice flags
+        .fr_next = -1,              // On no process's frame list
+        .fr_prev = -1,
+        .fr_rmap = -1               // Mapped by no page table entry
     };
 
     int i;
@@ -55,9 +61,14 @@ SYSCALL frame_table_map() {
         frm_tab[i].fr_refcnt = initValues.fr_refcnt;
         frm_tab[i].fr_type = initValues.fr_type;
         frm_tab[i].fr_dirty = initValues.fr_dirty;
+        frm_tab[i].fr_flags = initValues.fr_flags;
+        frm_tab[i].fr_next = initValues.fr_next;
+        frm_tab[i].fr_prev = initValues.fr_prev;
+        frm_tab[i].fr_rmap = initValues.fr_rmap;
     }
+    rmap_init();
 
-    restore(ps);
+    pgunlock(PGL_FRM);
     return OK;
 }
 
@@ -78,31 +89,45 @@ SYSCALL frame_table_map() {
 */
 
 SYSCALL get_frm(int* avail) {
-    STATWORD ps;
-    disable(ps);
+    pglock(PGL_FRM);
 
+    unsigned long long t0 = read_tsc();
     int i;
 
     // Iterate through the frame table to find an unmapped frame
     for (i = 0; i < NFRAMES; i++) {
         if (frm_tab[i].fr_status == FRM_UNMAPPED) {
             *avail = i;  // Store the index of the available frame
-            restore(ps);
+            vmhist_add(VMH_GETFRM, t0);
+            pgunlock(PGL_FRM);
             return OK;   // Return success
         }
     }
 
     // If no unmapped frame is found, invoke the page replacement policy
     int frame_id = pr_policy();
+    int victim_pid = frame_id > -1 ? frm_tab[frame_id].fr_pid : -1;
+
+    // Note the victim in the fault trace record
+    if (frame_id > -1) {
+        pft_cur.pt_vframe = frame_id;
+        pft_cur.pt_vpid = victim_pid;
+        pft_cur.pt_vvpno = frm_tab[frame_id].fr_vpno;
+    }
 
     // If the page replacement policy returns a valid frame and freeing is successful
     if (frame_id > -1 && free_frm(frame_id) == OK) {
+        frm_unlink(frame_id);
         *avail = frame_id;  // Store the index of the obtained frame
-        restore(ps);
+        vmstat.vs_evict++;
+        proctab[victim_pid].pevict++;
+        vmhist_add(VMH_GETFRM, t0);
+        pgunlock(PGL_FRM);
         return OK;          // Return success
     }
 
-    restore(ps);
+    vmhist_add(VMH_GETFRM, t0);
+    pgunlock(PGL_FRM);
     return SYSERR;  // Return system error if no frame can be obtained
 }
 
@@ -120,43 +145,186 @@ SYSCALL get_frm(int* avail) {
    OK if the frame is successfully freed, SYSERR otherwise.
 */
 
+LOCAL int unmap_frm(int i, int wback);
+
 SYSCALL free_frm(int i) {
-    STATWORD ps;
-    disable(ps);
+    pglock(PGL_FRM);
+
+    int status = unmap_frm(i, 1);
+
+    pgunlock(PGL_FRM);
+    return status;
+}
+
+/* Function: drop_frm
+   -------------------
+   Discards a resident page without writing it back (MADV_DONTNEED): the
+   frame leaves the replacement queue and becomes free, and the next touch
+   reads the page from its backing store again.  Locked frames stay.
+   Parameters:
+   - int i: Index of the frame to be dropped.
+   Returns:
+   OK if the frame is successfully dropped, SYSERR otherwise.
+*/
+
+SYSCALL drop_frm(int i) {
+    pglock(PGL_FRM);
+
+    if (i < 0 || i >= NFRAMES || frm_tab[i].fr_status != FRM_MAPPED ||
+        frm_tab[i].fr_type != FR_PAGE || (frm_tab[i].fr_flags & FRF_LOCK)) {
+        pgunlock(PGL_FRM);
+        return SYSERR;
+    }
+
+    remove_pr_queue(i);
+    unmap_frm(i, 0);
+    frm_unlink(i);
+
+    frm_tab[i].fr_status = FRM_UNMAPPED;
+    frm_tab[i].fr_pid = -1;
+    frm_tab[i].fr_vpno = 0;
+    frm_tab[i].fr_flags = 0;
+
+    pgunlock(PGL_FRM);
+    return OK;
+}
+
+/* Function: unmap_frm
+   --------------------
+   Clears the page table entry that maps frame i, optionally writing the
+   page back first, and frees the page table once it maps nothing.
+   Called with PGL_FRM held.
+*/
+
+LOCAL int unmap_frm(int i, int wback) {
 
     // Validate frame index and type
     if (i < 0 || i >= NFRAMES || frm_tab[i].fr_type != FR_PAGE) {
-        restore(ps);
         return SYSERR;  // Return system error if the frame is invalid
     }
 
-    // Calculate virtual address using the frame's vpno
-    unsigned long vaddr = frm_tab[i].fr_vpno * NBPG;
-    virt_addr_t *virtual_add = (virt_addr_t*)&vaddr;
-    unsigned int vpd_offset = virtual_add->pd_offset;
-    unsigned int vpt_offset = virtual_add->pt_offset;
+    // Clear every PTE that maps the frame, releasing their page tables
+    int pid = frm_tab[i].fr_pid;
+    int dirty = rmap_unmap(i);
+
+    // Write the frame content back to the store slot that backs this page;
+    // a clean page (never written, e.g. read-only) already matches it
+    int store, pageth;
+    if (wback && dirty && bsm_lookup(pid, frm_tab[i].fr_vpno * NBPG, &store, &pageth) == OK) {
+        write_bs((char *)((i + FRAME0) * NBPG), store, pageth);
+        vmstat.vs_wback++;
+        proctab[pid].pwback++;
+        pft_cur.pt_flags |= PFT_WBACK;
+    }
+
+    return OK;  // Return success
+}
 
-    // Get pointers to the page directory and page table entries
-    pd_t *pgdir_entry = proctab[frm_tab[i].fr_pid].pdbr + vpd_offset * sizeof(pd_t);
-    pt_t *pgtbl_entry = (pt_t*)(pgdir_entry->pd_base * NBPG + vpt_offset * sizeof(pt_t));
 
-    // Write the frame content back to the backing store
-    write_bs((i + FRAME0) * NBPG, proctab[frm_tab[i].fr_pid].store, frm_tab[i].fr_vpno - proctab[frm_tab[i].fr_pid].vhpno);
+/* Function: frm_link
+   -------------------
+   Puts frame i, whose fr_pid is already set, at the head of the owner's
+   frame list.  Pages are always linked after their page table, so a page
+   precedes its table on the list.
+*/
 
-    // Reset the present bit of the page table entry
-    pgtbl_entry->pt_pres = 0;
+void frm_link(int pid, int i) {
+    frm_tab[i].fr_prev = -1;
+    frm_tab[i].fr_next = proctab[pid].pfrhead;
+    if (proctab[pid].pfrhead != -1) {
+        frm_tab[proctab[pid].pfrhead].fr_prev = i;
+    }
+    proctab[pid].pfrhead = i;
+}
 
-    // Decrement the reference count of the corresponding page table frame
-    frm_tab[pgdir_entry->pd_base - FRAME0].fr_refcnt--;
+/* Function: frm_unlink
+   ---------------------
+   Takes frame i off its owner's frame list.  Frames on no list (the
+   global page tables) are left alone.
+*/
 
-    // Unmap the page table frame if the reference count becomes zero
-    if (frm_tab[pgdir_entry->pd_base - FRAME0].fr_refcnt == 0) {
-        pgdir_entry->pd_pres = 0;
+void frm_unlink(int i) {
+    int pid = frm_tab[i].fr_pid;
+    int prev = frm_tab[i].fr_prev;
+    int next = frm_tab[i].fr_next;
 
-        // Reset the frame table entry for the page table frame
-        frm_tab[pgdir_entry->pd_base - FRAME0] = (fr_map_t){FRM_UNMAPPED, FR_PAGE, -1, 4096};
+    if (prev != -1) {
+        frm_tab[prev].fr_next = next;
+    } else if (pid >= 0 && pid < NPROC && proctab[pid].pfrhead == i) {
+        proctab[pid].pfrhead = next;
+    } else {
+        return;
     }
+    if (next != -1) {
+        frm_tab[next].fr_prev = prev;
+    }
+    frm_tab[i].fr_next = frm_tab[i].fr_prev = -1;
+}
 
-    restore(ps);
-    return OK;  // Return success
-}
\ No newline at end of file
+/* Function: release_frms
+   -----------------------
+   Frees the frames of pid that hold pages of backing store store or,
+   with store == -1, every frame the process owns: its pages, its page
+   tables and its page directory.  Dirty pages of xmmap()ed stores are
+   written back first in one pass; private heap pages are discarded.
+   Only the process's own frame list is walked, so the cost follows its
+   resident set rather than NFRAMES.
+*/
+
+void release_frms(int pid, int store) {
+    pglock(PGL_FRM);
+
+    int i, next, s, pageth;
+
+    // Pass 1: write back the dirty pages that outlive the mapping
+    for (i = proctab[pid].pfrhead; i != -1; i = frm_tab[i].fr_next) {
+        if (frm_tab[i].fr_type != FR_PAGE ||
+            bsm_lookup(pid, frm_tab[i].fr_vpno * NBPG, &s, &pageth) == SYSERR ||
+            (store != -1 && s != store) || bsm_tab[s].bs_pvt_heap) {
+            continue;
+        }
+        if (rmap_dirty(i, 1)) {
+            write_bs((char *)((i + FRAME0) * NBPG), s, pageth);
+            vmstat.vs_wback++;
+            proctab[pid].pwback++;
+        }
+    }
+
+    // Pass 2: free the pages.  Freeing a table's last page frees the
+    // table too; the table is further down the list, and taking it off
+    // fixes up this page's link, so next is read after unmap_frm().
+    for (i = proctab[pid].pfrhead; i != -1; i = next) {
+        if (frm_tab[i].fr_type != FR_PAGE ||
+            (store != -1 && (bsm_lookup(pid, frm_tab[i].fr_vpno * NBPG, &s, &pageth) == SYSERR ||
+                             s != store))) {
+            next = frm_tab[i].fr_next;
+            continue;
+        }
+        if (frm_tab[i].fr_flags & FRF_LOCK) {
+            proctab[pid].plocked--;
+            vm_nlocked--;
+        }
+        remove_pr_queue(i);
+        unmap_frm(i, 0);
+        next = frm_tab[i].fr_next;
+        frm_unlink(i);
+        frm_tab[i].fr_status = FRM_UNMAPPED;
+        frm_tab[i].fr_pid = -1;
+        frm_tab[i].fr_vpno = 0;
+        frm_tab[i].fr_flags = 0;
+    }
+
+    // Pass 3: whatever is left of a departing process is tables and the
+    // directory itself
+    if (store == -1) {
+        while ((i = proctab[pid].pfrhead) != -1) {
+            frm_unlink(i);
+            frm_tab[i].fr_status = FRM_UNMAPPED;
+            frm_tab[i].fr_pid = -1;
+            frm_tab[i].fr_type = FR_PAGE;
+            frm_tab[i].fr_refcnt = 0;
+        }
+    }
+
+    pgunlock(PGL_FRM);
+}
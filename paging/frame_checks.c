@@ -8,108 +8,140 @@ extern int page_replace_policy;
 
 /* 
    Implements the page replacement policy based on either Second-Chance (SC)
-   or Aging. Disables interrupts for atomicity during the policy execution.
+   or Aging. Holds the replacement queue lock while the policy runs.
    Parameters:
    None.
    Returns:
    The frame ID selected for replacement according to the policy.
 */
 int pr_policy() {
-    STATWORD ps;    // Save the current interrupt state
-    disable(ps);    // Disable interrupts for atomicity
+    pglock(PGL_PRQ);    // Keep other processes off the queue
 
+    unsigned long long t0 = read_tsc();  // Start of the policy latency sample
     int frameid = -1;     // Initialize the frame ID to -1 (indicating no frame selected yet)
-    int tmpprev = -1;   // Initialize temporary previous frame ID to -1
     int current = pr_qhead;  // Start traversal from the head of the page replacement queue
-    int prev = -1;      // Initialize previous frame ID to -1
+
+    // Nothing to replace if no page frames are queued
+    if (pr_qhead == -1) {
+        pgunlock(PGL_PRQ);
+        return -1;
+    }
 
     // Iterate through the page replacement queue
     while (current != -1) {
-        // Calculate the virtual address using the current frame's virtual page number
-        unsigned long vaddr = frm_tab[current].fr_vpno * NBPG;
-        virt_addr_t *virtual_add = (virt_addr_t*)&vaddr;
-        unsigned int vpd_offset = virtual_add->pd_offset;
-        unsigned int vpt_offset = virtual_add->pt_offset;
+        // The frame counts as referenced if any process mapping it has
+        // touched it; the reverse map holds every PTE that maps it
+        int acc = rmap_refd(current, 0);
+
+        // A prefetched page that has since been referenced is a prefetch hit
+        if ((frm_tab[current].fr_flags & FRF_PREF) && acc) {
+            frm_tab[current].fr_flags &= ~FRF_PREF;
+            vmstat.vs_prefhit++;
+            proctab[frm_tab[current].fr_pid].pprefhit++;
+        }
 
-        // Access the page directory and page table entries for the virtual address
-        pd_t *pgdir_entry = proctab[currpid].pdbr + vpd_offset * sizeof(pd_t);
-        pt_t *pgtbl_entry = (pt_t*)(pgdir_entry->pd_base * NBPG + vpt_offset * sizeof(pt_t));
+        // Pages of a MADV_SEQUENTIAL region are not reused once the scan
+        // has passed them, so their access bit earns no second chance
+        int seq = frm_tab[current].fr_flags & FRF_SEQ;
 
         // Check the page replacement policy
         if (page_replace_policy == SC) {
             // Second-Chance policy: Check and update the access bit of the page table entry
 
-            if (pgtbl_entry->pt_acc == 1) {
-                pgtbl_entry->pt_acc = 0;  // Reset the access bit
-            } else if (pgtbl_entry->pt_acc == 0) {
-                // If the access bit is not set, remove the current frame from the queue
-                if (prev == -1) {
-                    pr_qhead = pr_qtab[current].next;
-                } else {
-                    pr_qtab[prev].next = pr_qtab[current].next;
-                }
-                frameid = current;  // Set the selected frame ID for replacement
+            if (acc && !seq) {
+                rmap_refd(current, 1);  // Reset the access bits
+            } else {
+                frameid = current;  // Not referenced: select it for replacement
                 break;
             }
         } else {  // Aging policy
             // Update the frame's age based on the access bit of the page table entry
 
-            pr_qtab[current].fr_age = (pr_qtab[current].fr_age >> 1) + (pgtbl_entry->pt_acc << 7);
-            
+            pr_qtab[current].fr_age = (pr_qtab[current].fr_age >> 1) + (seq ? 0 : acc << 7);
+            rmap_refd(current, 1);  // Sample the access bits once per sweep
+
             // If the frame's age is less than the current selected frame's age, update the selection
-            if (pr_qtab[current].fr_age < pr_qtab[frameid].fr_age) {
-                tmpprev = prev;
+            if (frameid == -1 || pr_qtab[current].fr_age < pr_qtab[frameid].fr_age) {
                 frameid = current;  // Update the selected frame ID
             }
         }
 
-        // Update traversal pointers
-        prev = current;
+        // Move on to the next queued frame
         current = pr_qtab[current].next;
     }
 
-    // If no frame was selected, choose the head of the queue
+    // If no frame was selected, choose the head of the queue, and take
+    // the victim off the queue
     if (frameid == -1) {
         frameid = pr_qhead;
-        pr_qhead = pr_qtab[pr_qhead].next;
-    } else if (tmpprev != -1) {
-        // Remove the selected frame from the middle of the queue
-        pr_qtab[tmpprev].next = pr_qtab[frameid].next;
     }
-    pr_qtab[frameid].next = -1;  // Set the next pointer of the selected frame to -1
+    remove_pr_queue(frameid);
 
-    restore(ps);    // Restore interrupts to their previous state
+    vmhist_add(VMH_POLICY, t0);
+    pgunlock(PGL_PRQ);
     return frameid;   // Return the selected frame ID for replacement
 }
 
 /* 
 Appends a frame to the end of the page replacement queue.
 If the queue is empty, the new frame becomes the head.
-Disables interrupts to ensure atomicity while modifying the queue.
+Holds the replacement queue lock while modifying the queue.
 Parameters:
   - frameid: Pointer to the frame identifier to be appended to the queue. 
 */
 void append_pr_queue(int *frameid) {
-    STATWORD ps;
-    disable(ps);  // Disable interrupts to ensure atomicity
+    pglock(PGL_PRQ);
 
-    // If the queue is empty, set the head to the new frame
+    // A newly queued frame starts with no age history
+    pr_qtab[*frameid].fr_age = 0;
+    pr_qtab[*frameid].next = -1;
+    pr_qtab[*frameid].prev = pr_qtail;
+
+    // If the queue is empty, set the head to the new frame; otherwise
+    // link it after the current tail
     if (pr_qhead == -1) {
         pr_qhead = *frameid;
     } else {
-        int current = pr_qhead;
+        pr_qtab[pr_qtail].next = *frameid;
+    }
+    pr_qtail = *frameid;
+
+    pgunlock(PGL_PRQ);
+}
 
-        // Traverse the queue to find the end
-        while (pr_qtab[current].next != -1) {
-            current = pr_qtab[current].next;
-        }
 
-        // Append the new frame to the end of the queue
-        pr_qtab[current].next = *frameid;
-        pr_qtab[*frameid].next = -1;
+/* 
+Removes a frame from the page replacement queue, wherever it is, in
+constant time.  Frames that are not queued (page tables, locked pages)
+are left alone.
+Parameters:
+  - frameid: The frame to be removed.
+*/
+void remove_pr_queue(int frameid) {
+    pglock(PGL_PRQ);
+
+    int prev = pr_qtab[frameid].prev;
+    int next = pr_qtab[frameid].next;
+
+    // Only the head has no predecessor
+    if (prev == -1 && pr_qhead != frameid) {
+        pgunlock(PGL_PRQ);
+        return;
+    }
+
+    if (prev == -1) {
+        pr_qhead = next;
+    } else {
+        pr_qtab[prev].next = next;
+    }
+    if (next == -1) {
+        pr_qtail = prev;
+    } else {
+        pr_qtab[next].prev = prev;
     }
+    pr_qtab[frameid].next = pr_qtab[frameid].prev = -1;
 
-    restore(ps);  // Restore interrupts
+    pgunlock(PGL_PRQ);
 }
 
 
@@ -130,5 +162,7 @@ void init_page_replace() {
         pr_qtab[i].frameid = i;   // Assign the frame ID to the current queue entry
         pr_qtab[i].fr_age = 0;  // Initialize the age of the frame to 0
         pr_qtab[i].next = -1;   // Initialize the next pointer to -1 (end of the queue)
+        pr_qtab[i].prev = -1;   // Not queued
     }
+    pr_qhead = pr_qtail = -1;
 }
\ No newline at end of file
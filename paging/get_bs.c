@@ -5,21 +5,20 @@
 
 int get_bs(bsd_t bs_id, unsigned int npages) {
 
-  STATWORD ps;
-  disable(ps);
+  pglock(PGL_BSM);
 
   if (bs_id < 0 || bs_id > 7){
-    restore(ps);
+    pgunlock(PGL_BSM);
     return SYSERR;
   }
 
   if (npages <= 0 || npages > 256){
-    restore(ps);
+    pgunlock(PGL_BSM);
     return SYSERR;
   }
 
   if (bsm_tab[bs_id].bs_pvt_heap == 1){
-    restore(ps);
+    pgunlock(PGL_BSM);
     return SYSERR;
   }
 
@@ -27,16 +26,16 @@ int get_bs(bsd_t bs_id, unsigned int npages) {
     bsm_tab[bs_id].bs_status = BSM_MAPPED;
     bsm_tab[bs_id].bs_pid = currpid;
 
-    restore(ps);
+    pgunlock(PGL_BSM);
     return npages;
   }
 
   else{
-    restore(ps);
+    pgunlock(PGL_BSM);
     return bsm_tab[bs_id].bs_npages;
   }
 
-  restore(ps);
+  pgunlock(PGL_BSM);
   return SYSERR;
    				
 }
\ No newline at end of file
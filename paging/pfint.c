@@ -1,16 +1,88 @@
 #include <conf.h>
+#include <i386.h>
 #include <kernel.h>
 #include <paging.h>
 #include <proc.h>
+#include <stdio.h>
+
+#define NPFSTK  2048    /* words of the page fault task's stack */
+
+unsigned long pfrsvstk[NRSVSTK];    /* stack of a process being killed */
+LOCAL unsigned long pfstk[NPFSTK];
+
+LOCAL void read_ahead(pt_t *, unsigned long, int);
+LOCAL void pf_doom(void);
+LOCAL void pf_doomed(void);
+
+/*
+   Sets up the page fault task: the second TSS runs pfintr on its own
+   stack, starting with interrupts off, in the null process's page
+   directory, and gate 14 becomes a task gate to it.  Called once paging
+   is set up.
+*/
+void pfinit(void) {
+    struct tss *t = &i386_tasks[1];
+
+    t->ts_eip = (unsigned int) pfintr;
+    t->ts_esp = t->ts_ebp = (unsigned int) &pfstk[NPFSTK];
+    t->ts_efl = 0x2;
+    t->ts_pdbr = proctab[NULLPROC].pdbr;
+    t->ts_es = t->ts_fs = t->ts_gs = 0x10;
+    set_tvec(14, 0x30);
+    set_evec(7, (u_long) fpuintr);
+}
 
 SYSCALL pfint() {
     STATWORD ps;
+
+    // Serve interrupts while the fault is handled, as far as the faulting
+    // process could take them: restore() puts back the mask it ran with
+    // and sets IF.  resched() waits until pfintr returns (see pglock.c).
     disable(ps);
+    restore(ps);
+
+    unsigned long long t0 = read_tsc();
 
     // Read the virtual address that caused the page fault
     unsigned long faulted_addr = read_cr2();
     virt_addr_t *virt_addr = (virt_addr_t*)&faulted_addr;
 
+    // Start the trace record; get_frm/free_frm fill in any victim
+    pft_cur.pt_tsc = t0;
+    pft_cur.pt_vaddr = faulted_addr;
+    pft_cur.pt_errcode = pferrcode;
+    pft_cur.pt_pid = currpid;
+    pft_cur.pt_frame = pft_cur.pt_vframe = pft_cur.pt_vpid = -1;
+    pft_cur.pt_vvpno = 0;
+    pft_cur.pt_flags = 0;
+
+    // A fault on a present page is a write to a read-only page; the
+    // process gets no second try
+    if (pferrcode & PFE_PRES) {
+        pft_cur.pt_flags |= PFT_PROT;
+        pftrace_log();
+        vmstat.vs_protflt++;
+        kprintf("pid %d: write to read-only page at 0x%08x\n", currpid, faulted_addr);
+        pf_doom();
+        return SYSERR;
+    }
+
+    // A fault in a virtual stack grows it by the touched page, unless it
+    // is past the reserve (the guard page) or no frame can be had
+    if (proctab[currpid].pvstk > 0 && faulted_addr >= VSTK_BASE) {
+        if (vstk_grow(currpid, faulted_addr) == SYSERR) {
+            kprintf("pid %d: stack overflow at 0x%08x\n", currpid, faulted_addr);
+            pf_doom();
+            return SYSERR;
+        }
+        vmstat.vs_minflt++;
+        proctab[currpid].pminflt++;
+        pftrace_log();
+        i386_tasks[0].ts_pdbr = proctab[currpid].pdbr;
+        vmhist_add(VMH_FAULT, t0);
+        return OK;
+    }
+
     // Extract the page directory and page table offsets from the virtual address
     unsigned int pd_offset = virt_addr->pd_offset;
     unsigned int pt_offset = virt_addr->pt_offset;
@@ -18,32 +90,92 @@ SYSCALL pfint() {
     // Get the current process's page directory base register (pdbr)
     pd_t *pd_entry = proctab[currpid].pdbr + pd_offset * sizeof(pd_t);
 
-    // Calculate the address of the page table entry
-    pt_t *pt_entry = (pt_t*)(pd_entry->pd_base * NBPG + pt_offset * sizeof(pt_t));
+    // The frames and the store map are held until the page is in, copies
+    // included; interrupts are served meanwhile
+    pglock(PGL_BSM);
+    pglock(PGL_FRM);
 
     // Handle the page directory entry
     handle_page_directory(pd_entry);
 
-    // Handle the page table entry
-    handle_page_table(pt_entry, faulted_addr);
+    // Calculate the address of the page table entry (the table may be new)
+    pt_t *pt_entry = (pt_t*)(pd_entry->pd_base * NBPG + pt_offset * sizeof(pt_t));
 
-    // Update the page directory base register and restore interrupts
-    write_cr3(proctab[currpid].pdbr);
-    restore(ps);
+    // Handle the page table entry; a fault that reads the backing store is major
+    int major = handle_page_table(pt_entry, faulted_addr);
+    if (major == SYSERR) {
+        pgunlock(PGL_FRM);
+        pgunlock(PGL_BSM);
+        pftrace_log();
+        kprintf("pid %d: no frame for page at 0x%08x\n", currpid, faulted_addr);
+        pf_doom();
+        return SYSERR;
+    }
+    if (major) {
+        vmstat.vs_majflt++;
+        proctab[currpid].pmajflt++;
+    } else {
+        vmstat.vs_minflt++;
+        proctab[currpid].pminflt++;
+    }
+    pftrace_log();
+
+    // Read ahead in regions advised MADV_SEQUENTIAL
+    int store, pageth;
+    if (major && bsm_lookup(currpid, faulted_addr, &store, &pageth) == OK &&
+        bsm_tab[store].bs_advice == MADV_SEQUENTIAL) {
+        read_ahead(pt_entry, faulted_addr, bsm_tab[store].bs_npages - pageth - 1);
+    }
+    pgunlock(PGL_FRM);
+    pgunlock(PGL_BSM);
+
+    // The faulting task resumes in its address space: the CPU reloads
+    // CR3 from its TSS, which also flushes the TLB
+    i386_tasks[0].ts_pdbr = proctab[currpid].pdbr;
+    vmhist_add(VMH_FAULT, t0);
     return OK;
 }
 
+/*
+   Ends the faulting process: it resumes in pf_doomed() on the reserve
+   stack with interrupts off, instead of retrying the access.  Killing it
+   here is not possible, since the page fault task cannot reschedule.
+*/
+LOCAL void pf_doom(void) {
+    struct tss *t = &i386_tasks[0];
+
+    t->ts_eip = (unsigned int) pf_doomed;
+    t->ts_esp = t->ts_ebp = (unsigned int) &pfrsvstk[NRSVSTK - 1];
+    t->ts_efl &= ~0x200;
+    t->ts_pdbr = proctab[currpid].pdbr;
+}
+
+LOCAL void pf_doomed(void) {
+    kill(currpid);
+}
+
+/*
+   handle_page_directory() gives the page table of pd_entry a zeroed
+   frame if it has none, and handle_page_table() reads the page of
+   pt_entry into a frame, returning 1 if that read the backing store, 0
+   if not and SYSERR if no frame or reverse map record was left.  Both
+   are called with PGL_BSM and PGL_FRM held.
+*/
 void handle_page_directory(pd_t *pd_entry) {
     // Check if the page directory entry is not present
     if (!pd_entry->pd_pres) {
         int new_fr_num;
         get_frm(&new_fr_num);
+        pft_cur.pt_flags |= PFT_NEWPT;
 
         // Update information in the frame table for the new page directory
 
         frm_tab[new_fr_num].fr_status = FRM_MAPPED;
         frm_tab[new_fr_num].fr_type = FR_TBL;
         frm_tab[new_fr_num].fr_pid = currpid;
+        frm_tab[new_fr_num].fr_refcnt = 0;
+        frm_tab[new_fr_num].fr_vpno = (pd_entry - (pd_t *)proctab[currpid].pdbr) << 10;
+        frm_link(currpid, new_fr_num);
 
         // Define a structure for page directory entry initialization values
         pd_t pd_entry_init = {
@@ -87,11 +219,31 @@ void handle_page_directory(pd_t *pd_entry) {
     }
 }
 
-void handle_page_table(pt_t *pt_entry, unsigned long vaddr) {
+int handle_page_table(pt_t *pt_entry, unsigned long vaddr) {
     // Check if the page table entry is not present
     if (!pt_entry->pt_pres) {
+        // Take the new page's reference on the page table first: the frame
+        // get_frm() evicts may be the last page in this table, and dropping
+        // that page would otherwise free the table under pt_entry
+        fr_map_t *pt_frame = &frm_tab[(unsigned long)pt_entry / NBPG - FRAME0];
+        pt_frame->fr_refcnt++;
+
         int new_pt_num;
-        get_frm(&new_pt_num);
+        if (get_frm(&new_pt_num) == SYSERR) {
+            pt_frame->fr_refcnt--;
+            return SYSERR;
+        }
+
+        // Record the mapping before the frame is used; with no reverse map
+        // record left the frame goes back unused and the fault fails
+        if (rmap_add(new_pt_num, currpid, pt_entry) == SYSERR) {
+            frm_tab[new_pt_num].fr_status = FRM_UNMAPPED;
+            frm_tab[new_pt_num].fr_pid = -1;
+            frm_tab[new_pt_num].fr_vpno = 0;
+            frm_tab[new_pt_num].fr_flags = 0;
+            pt_frame->fr_refcnt--;
+            return SYSERR;
+        }
         int *p = &new_pt_num;
         append_pr_queue(p);
 
@@ -101,18 +253,86 @@ void handle_page_table(pt_t *pt_entry, unsigned long vaddr) {
         frm_tab[new_pt_num].fr_type = FR_PAGE;
         frm_tab[new_pt_num].fr_pid = currpid;
         frm_tab[new_pt_num].fr_vpno = vaddr / NBPG;
-
-        // Increment the reference count of the page directory entry's frame
-        frm_tab[pt_entry->pt_base - FRAME0].fr_refcnt++;
+        frm_link(currpid, new_pt_num);
 
         // Get information about the backing store and read the page from it
+        // unless the store slot is known to be dead, which gives a zero page
         int bs_id, pageth;
-        bsm_lookup(currpid, vaddr, &bs_id, &pageth);
-        read_bs((char*)((FRAME0 + new_pt_num) * NBPG), bs_id, pageth);
+        int writable = 1;
+        int major = 1;
+        frm_tab[new_pt_num].fr_flags = 0;
+        if (bsm_lookup(currpid, vaddr, &bs_id, &pageth) == OK) {
+            if (BS_ZERO(&bsm_tab[bs_id], pageth)) {
+                bzero((char*)((FRAME0 + new_pt_num) * NBPG), NBPG);
+                bsm_zero(bs_id, pageth, 1, 0);
+                major = 0;
+            } else {
+                read_bs((char*)((FRAME0 + new_pt_num) * NBPG), bs_id, pageth);
+            }
+            if (bsm_tab[bs_id].bs_advice == MADV_SEQUENTIAL) {
+                frm_tab[new_pt_num].fr_flags = FRF_SEQ;
+            }
+            writable = !BS_RDONLY(&bsm_tab[bs_id], pageth);
+        }
 
         // Update information in the page table entry for the new page
         pt_entry->pt_pres = 1;
-        pt_entry->pt_write = 1;
+        pt_entry->pt_write = writable;
         pt_entry->pt_base = FRAME0 + new_pt_num;
+        pft_cur.pt_frame = new_pt_num;
+        if (major) {
+            pft_cur.pt_flags |= PFT_MAJOR;
+        }
+        return major;
     }
-}
\ No newline at end of file
+    return 0;
+}
+/*
+   Brings the page at vaddr of the current process into memory ahead of
+   use (read-ahead and MADV_WILLNEED).  The page is flagged FRF_PREF so
+   pr_policy() can count a prefetch hit once it is referenced.
+   Returns 1 if the page was read in, 0 if it was already resident and
+   SYSERR if no mapping covers vaddr or no frame could be had for it.
+*/
+int prefetch_page(unsigned long vaddr) {
+    int store, pageth;
+    pglock(PGL_BSM);
+    if (bsm_lookup(currpid, vaddr, &store, &pageth) == SYSERR) {
+        pgunlock(PGL_BSM);
+        return SYSERR;
+    }
+    pglock(PGL_FRM);
+
+    virt_addr_t *virt_addr = (virt_addr_t*)&vaddr;
+    pd_t *pd_entry = proctab[currpid].pdbr + virt_addr->pd_offset * sizeof(pd_t);
+    handle_page_directory(pd_entry);
+    pt_t *pt_entry = (pt_t*)(pd_entry->pd_base * NBPG + virt_addr->pt_offset * sizeof(pt_t));
+
+    int got = handle_page_table(pt_entry, vaddr);
+    if (got > 0) {
+        frm_tab[pt_entry->pt_base - FRAME0].fr_flags |= FRF_PREF;
+    }
+    pgunlock(PGL_FRM);
+    pgunlock(PGL_BSM);
+    return got;
+}
+
+/*
+   Reads up to NREADAHEAD pages following the faulting page, but no more
+   than left pages (the rest of the region).  The faulting page is marked
+   referenced and loses FRF_SEQ meanwhile, so the evictions made to hold
+   the read-ahead cannot take it before the faulting access is retried.
+*/
+LOCAL void read_ahead(pt_t *pt_entry, unsigned long vaddr, int left) {
+    fr_map_t *frame = &frm_tab[pt_entry->pt_base - FRAME0];
+    int k;
+
+    pt_entry->pt_acc = 1;
+    frame->fr_flags &= ~FRF_SEQ;
+    for (k = 1; k <= NREADAHEAD && k <= left; k++) {
+        if (prefetch_page(vaddr + k * NBPG) == SYSERR) {
+            break;
+        }
+    }
+    frame->fr_flags |= FRF_SEQ;
+}
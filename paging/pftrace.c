@@ -0,0 +1,125 @@
+/* pftrace.c - pftrace, pftrace_clear, pftrace_log, pftrace_dump */
+
+#include <conf.h>
+#include <kernel.h>
+#include <proc.h>
+#include <paging.h>
+#include <stdio.h>
+
+extern	int	console_dev;
+
+struct	pftrec	pft_cur;		/* record being built by pfint	*/
+int	pft_enabled = 0;		/* nonzero while tracing	*/
+
+LOCAL	struct	pftrec	pft_ring[NPFTRACE];
+LOCAL	int	pft_next;		/* ring slot for the next record*/
+LOCAL	unsigned long	pft_total;	/* records logged since clear	*/
+
+LOCAL	void	pft_frame(int type, char *payload, int len);
+
+/*-------------------------------------------------------------------------
+ * pftrace - turn fault tracing on or off, returning the previous setting
+ *-------------------------------------------------------------------------
+ */
+SYSCALL pftrace(int on)
+{
+	STATWORD ps;
+	int	was;
+
+	disable(ps);
+	was = pft_enabled;
+	pft_enabled = on ? 1 : 0;
+	restore(ps);
+	return(was);
+}
+
+/*-------------------------------------------------------------------------
+ * pftrace_clear - discard every record in the trace ring
+ *-------------------------------------------------------------------------
+ */
+SYSCALL pftrace_clear(void)
+{
+	STATWORD ps;
+
+	disable(ps);
+	pft_next = 0;
+	pft_total = 0;
+	restore(ps);
+	return(OK);
+}
+
+/*-------------------------------------------------------------------------
+ * pftrace_log - append pft_cur to the ring (called by pfint)
+ *-------------------------------------------------------------------------
+ */
+void pftrace_log(void)
+{
+	if (!pft_enabled)
+		return;
+	pft_ring[pft_next] = pft_cur;
+	if (++pft_next >= NPFTRACE)
+		pft_next = 0;
+	pft_total++;
+}
+
+/*-------------------------------------------------------------------------
+ * pftrace_dump - stream the ring, oldest record first, to the console
+ *-------------------------------------------------------------------------
+ */
+SYSCALL pftrace_dump(void)
+{
+	STATWORD ps;
+	unsigned long	hdr[3];
+	int	nrec, i, slot;
+
+	disable(ps);
+	nrec = pft_total < NPFTRACE ? (int) pft_total : NPFTRACE;
+	slot = pft_total < NPFTRACE ? 0 : pft_next;
+
+	hdr[0] = PFT_VERSION | (sizeof(struct pftrec) << 16);
+	hdr[1] = nrec;
+	hdr[2] = pft_total - nrec;	/* records overwritten		*/
+	pft_frame(PFT_HDR, (char *) hdr, sizeof(hdr));
+	for (i = 0; i < nrec; i++) {
+		pft_frame(PFT_REC, (char *) &pft_ring[slot],
+			sizeof(struct pftrec));
+		if (++slot >= NPFTRACE)
+			slot = 0;
+	}
+	pft_frame(PFT_END, NULL, 0);
+	restore(ps);
+	return(nrec);
+}
+
+/*-------------------------------------------------------------------------
+ * pft_putc - send one byte of a frame body, escaping reserved values
+ *-------------------------------------------------------------------------
+ */
+LOCAL void pft_putc(unsigned char c)
+{
+	if (c == PFT_FLAG || c == PFT_ESC || c == '\n') {
+		kputc(console_dev, PFT_ESC);
+		c ^= 0x20;
+	}
+	kputc(console_dev, c);
+}
+
+/*-------------------------------------------------------------------------
+ * pft_frame - send type and payload as one checksummed frame
+ *-------------------------------------------------------------------------
+ */
+LOCAL void pft_frame(int type, char *payload, int len)
+{
+	unsigned char	sum;
+	int	i;
+
+	kputc(console_dev, PFT_FLAG);
+	pft_putc(type);
+	sum = type;
+	for (i = 0; i < len; i++) {
+		pft_putc(payload[i]);
+		sum += payload[i];
+	}
+	pft_putc(-sum);
+	kputc(console_dev, PFT_FLAG);
+}
@@ -0,0 +1,96 @@
+/* pglock.c - pglock, pgunlock, pglock_print */
+
+#include <conf.h>
+#include <kernel.h>
+#include <proc.h>
+#include <paging.h>
+#include <stdio.h>
+
+/*
+ * The pager's tables are guarded by three locks rather than by turning
+ * interrupts off around whole operations: PGL_FRM covers the frame
+ * table, the owners' frame lists, the reverse map and the page tables
+ * held in frames; PGL_PRQ the replacement queue; PGL_BSM bsm_tab and the
+ * backing stores themselves.  No interrupt handler touches any of them,
+ * so a lock only has to keep other processes out, which on one CPU
+ * means not switching: while one is held resched() merely notes that a
+ * switch is wanted (pgresched), and pgunlock() makes it once the last
+ * lock goes.  Interrupts stay on meanwhile; they are off only for the
+ * bookkeeping below, so page copies and policy scans no longer hold up
+ * the clock or the serial line.
+ *
+ * The page fault task cannot switch either (see pfint.c).  It runs with
+ * pfbusy set, which makes resched() wait in the same way, and the first
+ * clock interrupt after the fault does the switch (clkint.S, tickless.c).
+ *
+ * A holder must not block, nor touch a page that can fault, since the
+ * fault would need the lock it holds.  Locks nest, and as nobody ever
+ * waits for one, they can be taken in any order.
+ */
+
+struct	pglentry	pglocks[NPGLOCK];
+int	pgnopreempt;			/* locks held, nested ones too	*/
+int	pgresched;			/* resched() waits for them	*/
+int	pfbusy;				/* the page fault task runs	*/
+
+LOCAL	char	*pgl_name[NPGLOCK] = { "frames", "prqueue", "bsm" };
+
+/*-------------------------------------------------------------------------
+ * pglock - take paging lock l
+ *-------------------------------------------------------------------------
+ */
+void pglock(int l)
+{
+	STATWORD ps;
+	struct	pglentry	*lp = &pglocks[l];
+
+	disable(ps);
+	if (lp->pl_depth++ == 0) {
+		lp->pl_fault = pfbusy;
+		lp->pl_acquires++;
+		lp->pl_t0 = read_tsc();
+	} else if (pfbusy && !lp->pl_fault)
+		panic("page fault inside a paging lock");
+	pgnopreempt++;
+	restore(ps);
+}
+
+/*-------------------------------------------------------------------------
+ * pgunlock - give back paging lock l, switching if resched() waited for
+ *            it and the caller can be switched
+ *-------------------------------------------------------------------------
+ */
+void pgunlock(int l)
+{
+	STATWORD ps;
+	struct	pglentry	*lp = &pglocks[l];
+	unsigned long long held;
+
+	disable(ps);
+	if (--lp->pl_depth == 0) {
+		held = read_tsc() - lp->pl_t0;
+		if (held > lp->pl_maxhold)
+			lp->pl_maxhold = held >> 32 ? 0xffffffffUL :
+				(unsigned long) held;
+	}
+
+	/* a caller inside disable() (IRQ 0 masked, e.g. kill()) gets to
+	   finish first; its restore() lets the next tick switch */
+	if (--pgnopreempt == 0 && pgresched && !pfbusy && !(ps[0] & 1))
+		resched();
+	restore(ps);
+}
+
+/*-------------------------------------------------------------------------
+ * pglock_print - show how often each lock was taken and its longest hold
+ *-------------------------------------------------------------------------
+ */
+void pglock_print(void)
+{
+	int	l;
+
+	for (l = 0; l < NPGLOCK; l++)
+		kprintf("lock %-8s acquires %u maxhold %u cycles\n",
+			pgl_name[l], pglocks[l].pl_acquires,
+			pglocks[l].pl_maxhold);
+}
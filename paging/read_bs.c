@@ -10,24 +10,25 @@ SYSCALL read_bs(char *dst, bsd_t bs_id, int page) {
   /* fetch page page from map map_id
      and write beginning at dst.
   */
-   STATWORD ps;
-   disable(ps);
+   pglock(PGL_BSM);
 
 // total number of backing stores = 8
    if (bs_id < 0 || bs_id >= 8){
-      restore(ps);
+      pgunlock(PGL_BSM);
       return SYSERR;
    }
 
-// total number of pages for each backing store = 128
-   if (page < 0 || page >= 128){
-      restore(ps);
+// total number of pages for each backing store = 256 (1 MB)
+   if (page < 0 || page >= 256){
+      pgunlock(PGL_BSM);
       return SYSERR;
    }   
 
+   unsigned long long t0 = read_tsc();
    void * phy_addr = (BACKING_STORE_BASE) + (bs_id*BACKING_STORE_UNIT_SIZE) + (page*NBPG);
    bcopy(phy_addr, (void*)dst, NBPG);
+   vmhist_add(VMH_BSIO, t0);
 
-   restore(ps);
+   pgunlock(PGL_BSM);
    return OK;
 }
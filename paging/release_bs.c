@@ -5,8 +5,7 @@
 
 SYSCALL release_bs(bsd_t bs_id) {
 
-  STATWORD ps;
-  disable(ps);
+  pglock(PGL_BSM);
 
   /* release the backing store with ID bs_id */
 
@@ -16,7 +15,7 @@ SYSCALL release_bs(bsd_t bs_id) {
 
   if (bsm_tab[bs_id].bs_pid != currpid || bsm_tab[bs_id].bs_pvt_heap == 0){
 
-    restore(ps);
+    pgunlock(PGL_BSM);
     return SYSERR;
   }
 
@@ -26,7 +25,7 @@ SYSCALL release_bs(bsd_t bs_id) {
   // }
 
   free_bsm(bs_id);
-  restore(ps);
+  pgunlock(PGL_BSM);
   return OK;
 
 }
\ No newline at end of file
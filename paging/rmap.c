@@ -0,0 +1,158 @@
+/* rmap.c - rmap_init, rmap_add, rmap_refd, rmap_dirty, rmap_unmap */
+
+#include <conf.h>
+#include <kernel.h>
+#include <proc.h>
+#include <paging.h>
+
+/*-------------------------------------------------------------------------
+ * rmap - reverse map from page frames to the PTEs that map them
+ *-------------------------------------------------------------------------
+ */
+
+rmap_t rmap_tab[NRMAP];     // Pool of (pid, PTE) mapping records
+int rmap_free;              // Head of the free record list
+
+LOCAL void rmap_pgtbl_put(int pid, pt_t *pte);
+
+/* Function: rmap_init
+   --------------------
+   Puts every mapping record on the free list.  Called by
+   frame_table_map(), which also empties each frame's own list.
+*/
+
+void rmap_init() {
+    int i;
+    for (i = 0; i < NRMAP; i++) {
+        rmap_tab[i].rm_pid = -1;
+        rmap_tab[i].rm_pte = NULL;
+        rmap_tab[i].rm_next = i + 1 < NRMAP ? i + 1 : -1;
+    }
+    rmap_free = 0;
+}
+
+/* Function: rmap_add
+   -------------------
+   Records that pte, in the page tables of pid, maps page frame i.
+   Called with PGL_FRM held.
+   Returns:
+   OK, or SYSERR if the record pool is exhausted.
+*/
+
+int rmap_add(int i, int pid, pt_t *pte) {
+    int r = rmap_free;
+
+    if (r == -1) {
+        return SYSERR;
+    }
+    rmap_free = rmap_tab[r].rm_next;
+
+    rmap_tab[r].rm_pid = pid;
+    rmap_tab[r].rm_pte = pte;
+    rmap_tab[r].rm_next = frm_tab[i].fr_rmap;
+    frm_tab[i].fr_rmap = r;
+    return OK;
+}
+
+/* Function: rmap_refd
+   --------------------
+   Tells whether any mapper has referenced page frame i: the accessed
+   bits of all its PTEs ORed together.  With clear set the bits are
+   cleared as they are sampled.
+*/
+
+int rmap_refd(int i, int clear) {
+    int r, acc = 0;
+
+    for (r = frm_tab[i].fr_rmap; r != -1; r = rmap_tab[r].rm_next) {
+        acc |= rmap_tab[r].rm_pte->pt_acc;
+        if (clear) {
+            rmap_tab[r].rm_pte->pt_acc = 0;
+        }
+    }
+    return acc;
+}
+
+/* Function: rmap_dirty
+   ---------------------
+   Tells whether any mapper has written page frame i, optionally
+   clearing the dirty bits (the caller is about to write the page back).
+*/
+
+int rmap_dirty(int i, int clear) {
+    int r, dirty = 0;
+
+    for (r = frm_tab[i].fr_rmap; r != -1; r = rmap_tab[r].rm_next) {
+        dirty |= rmap_tab[r].rm_pte->pt_dirty;
+        if (clear) {
+            rmap_tab[r].rm_pte->pt_dirty = 0;
+        }
+    }
+    return dirty;
+}
+
+/* Function: rmap_unmap
+   ---------------------
+   Removes every mapping of page frame i: each PTE is cleared, each page
+   table loses a reference (and is freed once it maps nothing), and the
+   records go back to the pool.  Costs O(mappers).
+   Called with PGL_FRM held.
+   Returns:
+   Nonzero if any mapper had dirtied the page.
+*/
+
+int rmap_unmap(int i) {
+    int r, next, dirty = 0;
+
+    for (r = frm_tab[i].fr_rmap; r != -1; r = next) {
+        pt_t *pte = rmap_tab[r].rm_pte;
+        next = rmap_tab[r].rm_next;
+
+        // Reset the present, accessed and dirty bits of the entry
+        dirty |= pte->pt_dirty;
+        pte->pt_pres = 0;
+        pte->pt_acc = 0;
+        pte->pt_dirty = 0;
+        rmap_pgtbl_put(rmap_tab[r].rm_pid, pte);
+
+        rmap_tab[r].rm_pid = -1;
+        rmap_tab[r].rm_pte = NULL;
+        rmap_tab[r].rm_next = rmap_free;
+        rmap_free = r;
+    }
+    frm_tab[i].fr_rmap = -1;
+    return dirty;
+}
+
+/* Function: rmap_pgtbl_put
+   -------------------------
+   Drops one reference to the page table holding pte and frees the
+   table, unhooking it from pid's page directory, once it is unused.  A
+   table's fr_vpno is the first virtual page it maps.
+*/
+
+LOCAL void rmap_pgtbl_put(int pid, pt_t *pte) {
+    int pt_frame = (unsigned long)pte / NBPG - FRAME0;
+
+    // Decrement the reference count of the page table frame
+    if (--frm_tab[pt_frame].fr_refcnt > 0) {
+        return;
+    }
+
+    pd_t *pgdir_entry = (pd_t *)proctab[pid].pdbr + (frm_tab[pt_frame].fr_vpno >> 10);
+    pgdir_entry->pd_pres = 0;
+    frm_unlink(pt_frame);
+
+    // Reset the frame table entry for the page table frame
+    frm_tab[pt_frame] = (fr_map_t){
+        .fr_status = FRM_UNMAPPED,
+        .fr_pid = -1,
+        .fr_vpno = 0,
+        .fr_refcnt = 0,
+        .fr_type = FR_PAGE,
+        .fr_dirty = 0,
+        .fr_next = -1,
+        .fr_prev = -1,
+        .fr_rmap = -1
+    };
+}
@@ -21,52 +21,58 @@ LOCAL	newpid();
 SYSCALL vcreate(procaddr,ssize,hsize,priority,name,nargs,args)
 	int	*procaddr;		/* procedure address		*/
 	int	ssize;			/* stack size in words		*/
-	int	hsize;			/* virtual heap size in pages	*/
+	int	hsize;			/* initial heap size in pages,	*/
+					/* with VSTACK for a stack in	*/
+					/* virtual memory		*/
 	int	priority;		/* process priority > 0		*/
 	char	*name;			/* name (for debugging)		*/
 	int	nargs;			/* number of args that follow	*/
 	long	args;			/* arguments (treated like an	*/
 					/* array in the code)		*/
 {
-	struct mblock *freemem_block;
+	struct vheap *vh;
+	int	vstk;
 	STATWORD 	ps;
 	disable(ps);
 
-	if (hsize <= 0 || hsize > 16*128){
-		// 16 backing stores and each has 128 pages
+	vstk = hsize & VSTACK;
+	hsize &= ~VSTACK;
+	if (hsize < 0 || hsize > VH_MAXPG){
+		// the heap can grow to one chunk per backing store
 		restore(ps);
 		return(SYSERR);
 	}
 
-	int bs_num;
 	int pid;
-	pid = create(procaddr,ssize,priority,name,nargs,args);
-	
-	/* sanity check to get backing store */
-	if (get_bsm(&bs_num) == SYSERR)
+	pid = mkproc(procaddr, ssize, priority, name, nargs,
+		(unsigned long *)&args, vstk);
+	if (pid == SYSERR)
 	{
 		restore(ps);
 		return SYSERR;
 	}
-	
-	int map_status = bsm_map(pid,4096,bs_num,hsize);
 
-	if (map_status == SYSERR)
+	/* the allocator's metadata stays in kernel memory */
+	vh = (struct vheap *)getmem(sizeof(struct vheap));
+	if ((int)vh == SYSERR)
 	{
+		kill(pid);
 		restore(ps);
 		return SYSERR;
 	}
+	vheap_init(vh, 4096 * NBPG);
+	proctab[pid].vheap = vh;
+	proctab[pid].store = -1;
+	proctab[pid].vhpno = 4096;
+	proctab[pid].vhpnpages = 0;
 
-	bsm_tab[bs_num].bs_pvt_heap = 1;
-
-	freemem_block = BACKING_STORE_BASE + (bs_num * BACKING_STORE_UNIT_SIZE); 	
-	freemem_block->mlen = hsize * NBPG;
-	freemem_block->mnext = NULL;
-
-	// proctab[pid].store = bs_num;
-	// proctab[pid].vhpno = 4096;
-	proctab[pid].vhpnpages = hsize;
-	proctab[pid].vmemlist->mnext = 4096 * NBPG;
+	/* backing stores are attached as the break reaches them */
+	if (vh_grow(pid, hsize) == SYSERR)
+	{
+		kill(pid);
+		restore(ps);
+		return SYSERR;
+	}
 	
 	restore(ps);	
 	return pid;
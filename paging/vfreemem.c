@@ -4,51 +4,82 @@
 #include <kernel.h>
 #include <mem.h>
 #include <proc.h>
+#include <paging.h>
 
 extern struct pentry proctab[];
 /*------------------------------------------------------------------------
- *  vfreemem  --  free a virtual memory block, returning it to vmemlist
+ *  vfreemem  --  free a virtual memory block, returning it to the vheap
  *------------------------------------------------------------------------
  */
 SYSCALL	vfreemem(block, size)
 	struct	mblock	*block;
 	unsigned size;
 {
-	STATWORD ps;    
-	struct	mblock	*p, *q, *proc_vmemlist;
-	unsigned top;
+	struct	vheap	*vh;
+	struct	vhchunk	*vc;
+	unsigned long	off;
+	int	c, p, s, n, i, next, prev;
 
-	if (size==0 || (unsigned)block < 4096 * 4096)
-	{
+	vh = proctab[currpid].vheap;
+	if (size==0 || vh == NULL || (unsigned long)block < vh->vh_base ||
+	    (off = (unsigned long)block - vh->vh_base) >=
+	    (unsigned long)vh->vh_npages * NBPG) {
 		return(SYSERR);
 	}
-	size = (unsigned)roundmb(size);
-	disable(ps);
-	proc_vmemlist = proctab[currpid].vmemlist;
-	for( p = proc_vmemlist->mnext ,q= proc_vmemlist;
+	p = off / NBPG;
+	off %= NBPG;
 
-	     p != (struct mblock *) NULL && p < block ;
-	     q=p,p=p->mnext )
-		;
+	/* a run: every page of it must be in use as part of a run */
+	if (size > VH_MAXOBJ) {
+		n = (size + NBPG - 1) / NBPG;
+		if (off != 0 || p + n > vh->vh_npages) {
+			return(SYSERR);
+		}
+		for (i = p; i < p + n; i++)
+			if (VH_CHUNK(vh, i)->vc_class[VH_SLOT(i)] != VHC_RUN) {
+				return(SYSERR);
+			}
+		vh_pgfree(vh, p, n);
+		vh_discard(currpid, p, n);
+		return(OK);
+	}
 
-	if (((top=q->mlen+(unsigned)q)>(unsigned)block && q!= proc_vmemlist) ||
-	    (p!=NULL && (size+(unsigned)block) > (unsigned)p )) {
-		restore(ps);
+	/* an object: its page must hold this size class */
+	c = vh_sizeclass(size);
+	vc = VH_CHUNK(vh, p);
+	s = VH_SLOT(p);
+	if (vc->vc_class[s] != c || off % (VH_MINOBJ << c) != 0 ||
+	    off >= vc->vc_bump[s]) {
 		return(SYSERR);
 	}
+	*(unsigned short *)block = vc->vc_flist[s];
+	vc->vc_flist[s] = off;
 
-	if ( q!= proc_vmemlist && top == (unsigned)block )
-			q->mlen += size;
-	else {
-		block->mlen = size;
-		block->mnext = p;
-		q->mnext = block;
-		q = block;
+	/* a page that was full has room again */
+	if (vc->vc_nfree[s]++ == 0) {
+		vc->vc_prev[s] = -1;
+		vc->vc_next[s] = next = vh->vh_partial[c];
+		if (next != -1)
+			VH_CHUNK(vh, next)->vc_prev[VH_SLOT(next)] = p;
+		vh->vh_partial[c] = p;
 	}
-	if ( (unsigned)( q->mlen + (unsigned)q ) == (unsigned)p) {
-		q->mlen += p->mlen;
-		q->mnext = p->mnext;
+
+	/* an empty page goes back to the free page map and is discarded,
+	   unless it is the only page of its class with room: that one is
+	   kept so a lone object allocated and freed in turn doesn't fault */
+	if (vc->vc_nfree[s] == NBPG / (VH_MINOBJ << c) &&
+	    (vh->vh_partial[c] != p || vc->vc_next[s] != -1)) {
+		prev = vc->vc_prev[s];
+		next = vc->vc_next[s];
+		if (prev != -1)
+			VH_CHUNK(vh, prev)->vc_next[VH_SLOT(prev)] = next;
+		else
+			vh->vh_partial[c] = next;
+		if (next != -1)
+			VH_CHUNK(vh, next)->vc_prev[VH_SLOT(next)] = prev;
+		vc->vc_next[s] = vc->vc_prev[s] = -1;
+		vh_pgfree(vh, p, 1);
+		vh_discard(currpid, p, 1);
 	}
-	restore(ps);
 	return(OK);
-}
\ No newline at end of file
+}
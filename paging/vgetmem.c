@@ -14,34 +14,63 @@ extern struct pentry proctab[];
 WORD	*vgetmem(nbytes)
 	unsigned nbytes;
 {
-	STATWORD ps;    
-	struct	mblock	*p, *q, *leftover, *proc_vmemlist;
-	
-	proc_vmemlist = proctab[currpid].vmemlist;
-	disable(ps);
-	if (nbytes==0 || proc_vmemlist->mnext == (struct mblock *) NULL) {
-		restore(ps);
+	struct	vheap	*vh;
+	struct	vhchunk	*vc;
+	unsigned long	addr;
+	unsigned	size;
+	int	c, p, s;
+
+	vh = proctab[currpid].vheap;
+	if (nbytes==0 || vh == NULL) {
 		return( (WORD *)SYSERR);
 	}
-	nbytes = (unsigned int) roundmb(nbytes);
 
-	for (q= proc_vmemlist,p= proc_vmemlist->mnext ;
-	     p != (struct mblock *) NULL ;
-	     q=p,p=p->mnext)
-		if ( p->mlen == nbytes) {
-			q->mnext = p->mnext;
-			restore(ps);
-			return( (WORD *)p );
-		} else if ( p->mlen > nbytes ) {
-			leftover = (struct mblock *)( (unsigned)p + nbytes );
-			q->mnext = leftover;
-			leftover->mnext = p->mnext;
-			leftover->mlen = p->mlen - nbytes;
-			restore(ps);
-			return( (WORD *)p );
+	/* large requests get whole pages; the heap grows if need be */
+	if (nbytes > VH_MAXOBJ) {
+		c = (nbytes + NBPG - 1) / NBPG;
+		if ((p = vh_pgalloc(currpid, c)) == SYSERR) {
+			return( (WORD *)SYSERR );
+		}
+		while (c-- > 0)
+			VH_CHUNK(vh, p + c)->vc_class[VH_SLOT(p + c)] = VHC_RUN;
+		return( (WORD *)(vh->vh_base + (unsigned long)p * NBPG) );
+	}
+
+	/* small ones come from a page of their size class */
+	c = vh_sizeclass(nbytes);
+	size = VH_MINOBJ << c;
+	if ((p = vh->vh_partial[c]) == -1) {
+		if ((p = vh_pgalloc(currpid, 1)) == SYSERR) {
+			return( (WORD *)SYSERR );
 		}
-	
-	restore(ps);
-	return( (WORD *)SYSERR );
+		vc = VH_CHUNK(vh, p);
+		s = VH_SLOT(p);
+		vc->vc_class[s] = c;
+		vc->vc_nfree[s] = NBPG / size;
+		vc->vc_flist[s] = VH_NONE;
+		vc->vc_bump[s] = 0;
+		vc->vc_prev[s] = -1;
+		vc->vc_next[s] = -1;
+		vh->vh_partial[c] = p;
+	}
+	vc = VH_CHUNK(vh, p);
+	s = VH_SLOT(p);
+
+	addr = vh->vh_base + (unsigned long)p * NBPG;
+	if (vc->vc_flist[s] != VH_NONE) {
+		addr += vc->vc_flist[s];
+		vc->vc_flist[s] = *(unsigned short *)addr;
+	} else {
+		addr += vc->vc_bump[s];
+		vc->vc_bump[s] += size;
+	}
 
-}
\ No newline at end of file
+	/* a full page leaves the partial list */
+	if (--vc->vc_nfree[s] == 0) {
+		vh->vh_partial[c] = vc->vc_next[s];
+		if (vc->vc_next[s] != -1)
+			VH_CHUNK(vh, vc->vc_next[s])->vc_prev[VH_SLOT(vc->vc_next[s])] = -1;
+		vc->vc_next[s] = -1;
+	}
+	return( (WORD *)addr );
+}
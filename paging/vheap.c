@@ -0,0 +1,342 @@
+/* vheap.c - vheap_init, vh_grow, vh_shrink, vheap_free, vh_sizeclass,
+ *	     vh_pgalloc, vh_pgfree, vh_discard, vh_pinned */
+
+#include <conf.h>
+#include <kernel.h>
+#include <proc.h>
+#include <paging.h>
+
+/*
+ * A private heap is carved into pages.  A page either holds objects of
+ * a single size class (VH_MINOBJ << c bytes), handed out first from its
+ * free list and then by bumping vc_bump, or it is one page of a run
+ * that satisfies a request larger than VH_MAXOBJ.  Pages of each class
+ * with room left are chained on vh_partial[c], so small requests and
+ * frees are O(1).  A freed object holds the offset of the next free
+ * object of its page; that is the only metadata kept in the heap.
+ *
+ * The heap's pages below the break are backed chunk by chunk: chunk c
+ * is a private backing store mapped at page c * VH_CHUNKPG of the heap,
+ * attached the first time the break crosses into it.  Frames are only
+ * taken when a page is touched, so a large break costs little.  A page
+ * that becomes free is discarded: its frame goes back to the pool and
+ * its store slot is marked dead, so the next touch gets a zero page
+ * without reading the store.
+ *
+ * Only its own process allocates from a heap, so vgetmem(), vfreemem(),
+ * vsbrk() and vtrim() run with interrupts on and take no lock; the
+ * pager's locks (pglock.c) are held where the heap meets the stores and
+ * frames, in vh_grow(), vh_shrink(), vh_discard() and vh_pinned().
+ */
+
+LOCAL	struct	vhchunk	*vh_attach(int, int);
+LOCAL	pt_t	*vh_pte(int, int);
+
+/*-------------------------------------------------------------------------
+ * vheap_init - set up an empty heap whose page 0 is at address base
+ *-------------------------------------------------------------------------
+ */
+void vheap_init(struct vheap *vh, unsigned long base)
+{
+	int	i;
+
+	vh->vh_base = base;
+	vh->vh_npages = 0;
+	for (i = 0; i < NVHCLASS; i++)
+		vh->vh_partial[i] = -1;
+	for (i = 0; i < NVHCHUNK; i++)
+		vh->vh_chunk[i] = NULL;
+}
+
+/*-------------------------------------------------------------------------
+ * vh_grow - move pid's heap break up by npages pages, attaching the
+ *           chunks the new pages fall in
+ *-------------------------------------------------------------------------
+ */
+int vh_grow(int pid, int npages)
+{
+	struct	vheap	*vh;
+	struct	vhchunk	*vc;
+	int	new, c, p;
+
+	pglock(PGL_BSM);
+	vh = proctab[pid].vheap;
+	if (vh == NULL || npages < 0 ||
+	    (new = vh->vh_npages + npages) > VH_MAXPG) {
+		pgunlock(PGL_BSM);
+		return(SYSERR);
+	}
+
+	/* every chunk must be there before any page is added */
+	for (c = vh->vh_npages / VH_CHUNKPG; c * VH_CHUNKPG < new; c++)
+		if (vh->vh_chunk[c] == NULL &&
+		    (vh->vh_chunk[c] = vh_attach(pid, c)) == NULL) {
+			pgunlock(PGL_BSM);
+			return(SYSERR);
+		}
+
+	for (p = vh->vh_npages; p < new; p++) {
+		vc = VH_CHUNK(vh, p);
+		vc->vc_class[VH_SLOT(p)] = VHC_FREE;
+		vc->vc_pmap[VH_SLOT(p) >> 5] |= 1UL << (p & 31);
+		vc->vc_nfreepg++;
+		bsm_tab[vc->vc_store].bs_npages = VH_SLOT(p) + 1;
+	}
+	vh->vh_npages = new;
+	proctab[pid].vhpnpages = new;
+	pgunlock(PGL_BSM);
+	return(OK);
+}
+
+/*-------------------------------------------------------------------------
+ * vh_shrink - move pid's heap break down by npages pages, all of which
+ *             must be free and unpinned; their frames are dropped, and
+ *             chunks left empty give their store back
+ *-------------------------------------------------------------------------
+ */
+int vh_shrink(int pid, int npages)
+{
+	struct	vheap	*vh;
+	struct	vhchunk	*vc;
+	int	new, c, p;
+
+	pglock(PGL_BSM);
+	vh = proctab[pid].vheap;
+	if (vh == NULL || npages < 0 || (new = vh->vh_npages - npages) < 0) {
+		pgunlock(PGL_BSM);
+		return(SYSERR);
+	}
+	for (p = new; p < vh->vh_npages; p++)
+		if (VH_CHUNK(vh, p)->vc_class[VH_SLOT(p)] != VHC_FREE ||
+		    vh_pinned(pid, p)) {
+			pgunlock(PGL_BSM);
+			return(SYSERR);
+		}
+
+	vh_discard(pid, new, vh->vh_npages - new);
+	for (p = new; p < vh->vh_npages; p++) {
+		vc = VH_CHUNK(vh, p);
+		vc->vc_pmap[VH_SLOT(p) >> 5] &= ~(1UL << (p & 31));
+		vc->vc_nfreepg--;
+	}
+
+	/* drop the chunks wholly above the new break */
+	for (c = (new + VH_CHUNKPG - 1) / VH_CHUNKPG; c < NVHCHUNK; c++) {
+		if ((vc = vh->vh_chunk[c]) == NULL)
+			continue;
+		bsm_tab[vc->vc_store].bs_npages = VH_CHUNKPG;
+		bsm_unmap(pid, vh->vh_base / NBPG + c * VH_CHUNKPG, 0);
+		freemem((struct mblock *) vc, sizeof(struct vhchunk));
+		vh->vh_chunk[c] = NULL;
+	}
+	if (new % VH_CHUNKPG)
+		bsm_tab[VH_CHUNK(vh, new)->vc_store].bs_npages = new % VH_CHUNKPG;
+	if (vh->vh_chunk[0] == NULL)
+		proctab[pid].store = -1;
+	vh->vh_npages = new;
+	proctab[pid].vhpnpages = new;
+	if (pid == currpid)
+		write_cr3(proctab[pid].pdbr);
+	pgunlock(PGL_BSM);
+	return(OK);
+}
+
+/*-------------------------------------------------------------------------
+ * vh_attach - give chunk c of pid's heap a private store and metadata
+ *-------------------------------------------------------------------------
+ */
+LOCAL struct vhchunk *vh_attach(int pid, int c)
+{
+	struct	vhchunk	*vc;
+	int	store, i;
+
+	if (get_bsm(&store) == SYSERR)
+		return(NULL);
+	vc = (struct vhchunk *) getmem(sizeof(struct vhchunk));
+	if ((int) vc == SYSERR)
+		return(NULL);
+	if (bsm_map(pid, proctab[pid].vheap->vh_base / NBPG + c * VH_CHUNKPG,
+	    store, 0) == SYSERR) {
+		freemem((struct mblock *) vc, sizeof(struct vhchunk));
+		return(NULL);
+	}
+	bsm_tab[store].bs_pvt_heap = 1;
+	bsm_zero(store, 0, VH_CHUNKPG, 1);	/* nothing in it is live yet */
+	if (c == 0)
+		proctab[pid].store = store;
+
+	vc->vc_store = store;
+	vc->vc_nfreepg = 0;
+	for (i = 0; i < VH_CHUNKPG; i++) {
+		vc->vc_next[i] = vc->vc_prev[i] = -1;
+		vc->vc_class[i] = VHC_FREE;
+		vc->vc_nfree[i] = vc->vc_flist[i] = vc->vc_bump[i] = 0;
+	}
+	for (i = 0; i < VH_CHUNKPG / 32; i++)
+		vc->vc_pmap[i] = 0;
+	return(vc);
+}
+
+/*-------------------------------------------------------------------------
+ * vheap_free - free the metadata of a heap whose process is gone (its
+ *              stores and frames are released with the process)
+ *-------------------------------------------------------------------------
+ */
+void vheap_free(struct vheap *vh)
+{
+	int	c;
+
+	for (c = 0; c < NVHCHUNK; c++)
+		if (vh->vh_chunk[c] != NULL)
+			freemem((struct mblock *) vh->vh_chunk[c],
+				sizeof(struct vhchunk));
+	freemem((struct mblock *) vh, sizeof(struct vheap));
+}
+
+/*-------------------------------------------------------------------------
+ * vh_sizeclass - size class for an nbytes request (nbytes <= VH_MAXOBJ)
+ *-------------------------------------------------------------------------
+ */
+int vh_sizeclass(unsigned nbytes)
+{
+	int	c;
+
+	for (c = 0; (VH_MINOBJ << c) < nbytes; c++)
+		;
+	return(c);
+}
+
+/*-------------------------------------------------------------------------
+ * vh_pgalloc - take npages contiguous free pages of pid's heap, growing
+ *              it if none are free, and return the first page number or
+ *              SYSERR.  Only the chunks' page maps are searched; a run
+ *              never spans two chunks.
+ *-------------------------------------------------------------------------
+ */
+int vh_pgalloc(int pid, int npages)
+{
+	struct	vheap	*vh;
+	struct	vhchunk	*vc;
+	int	c, limit, first, i, grow;
+
+	vh = proctab[pid].vheap;
+	if (npages <= 0 || npages > VH_CHUNKPG)
+		return(SYSERR);
+	for (;;) {
+		for (c = 0; c < NVHCHUNK; c++) {
+			if ((vc = vh->vh_chunk[c]) == NULL ||
+			    vc->vc_nfreepg < npages)
+				continue;
+			limit = vh->vh_npages - c * VH_CHUNKPG;
+			if (limit > VH_CHUNKPG)
+				limit = VH_CHUNKPG;
+			for (first = 0; first + npages <= limit; ) {
+				if ((first & 31) == 0 &&
+				    vc->vc_pmap[first >> 5] == 0) {
+					first += 32;	/* a fully used word */
+					continue;
+				}
+				for (i = 0; i < npages; i++)
+					if (!(vc->vc_pmap[(first + i) >> 5] &
+					    (1UL << ((first + i) & 31))))
+						break;
+				if (i == npages) {
+					for (i = first; i < first + npages; i++)
+						vc->vc_pmap[i >> 5] &=
+							~(1UL << (i & 31));
+					vc->vc_nfreepg -= npages;
+					return(c * VH_CHUNKPG + first);
+				}
+				first += i + 1;
+			}
+		}
+
+		/* nothing fits below the break: move it up and retry */
+		grow = npages > VH_GROW ? npages : VH_GROW;
+		if (grow > VH_MAXPG - vh->vh_npages)
+			grow = VH_MAXPG - vh->vh_npages;
+		if (grow <= 0 || vh_grow(pid, grow) == SYSERR)
+			return(SYSERR);
+	}
+}
+
+/*-------------------------------------------------------------------------
+ * vh_pgfree - return npages pages from page first to the free page maps
+ *-------------------------------------------------------------------------
+ */
+void vh_pgfree(struct vheap *vh, int first, int npages)
+{
+	struct	vhchunk	*vc;
+	int	p;
+
+	for (p = first; p < first + npages; p++) {
+		vc = VH_CHUNK(vh, p);
+		vc->vc_class[VH_SLOT(p)] = VHC_FREE;
+		vc->vc_pmap[VH_SLOT(p) >> 5] |= 1UL << (p & 31);
+		vc->vc_nfreepg++;
+	}
+}
+
+/*-------------------------------------------------------------------------
+ * vh_discard - drop the contents of npages free pages of pid's heap from
+ *              page first: resident frames are freed without write-back
+ *              and the store slots are marked dead.  A pinned page keeps
+ *              its frame, and its slot is left alone.
+ *-------------------------------------------------------------------------
+ */
+void vh_discard(int pid, int first, int npages)
+{
+	struct	vheap	*vh;
+	struct	vhchunk	*vc;
+	pt_t	*pt;
+	int	p;
+
+	pglock(PGL_BSM);
+	pglock(PGL_FRM);
+	vh = proctab[pid].vheap;
+	for (p = first; p < first + npages; p++) {
+		vc = VH_CHUNK(vh, p);
+		if ((pt = vh_pte(pid, p)) != NULL && pt->pt_pres &&
+		    drop_frm(pt->pt_base - FRAME0) == SYSERR)
+			continue;
+		bsm_zero(vc->vc_store, VH_SLOT(p), 1, 1);
+	}
+	if (pid == currpid)
+		write_cr3(proctab[pid].pdbr);
+	pgunlock(PGL_FRM);
+	pgunlock(PGL_BSM);
+}
+
+/*-------------------------------------------------------------------------
+ * vh_pinned - TRUE if page p of pid's heap is resident and vmlock()ed
+ *-------------------------------------------------------------------------
+ */
+int vh_pinned(int pid, int p)
+{
+	pt_t	*pt;
+	int	pinned;
+
+	pglock(PGL_FRM);
+	pt = vh_pte(pid, p);
+	pinned = pt != NULL && pt->pt_pres &&
+	    (frm_tab[pt->pt_base - FRAME0].fr_flags & FRF_LOCK);
+	pgunlock(PGL_FRM);
+	return(pinned ? TRUE : FALSE);
+}
+
+/*-------------------------------------------------------------------------
+ * vh_pte - the PTE of page p of pid's heap, or NULL if it has no page
+ *          table; PGL_FRM held
+ *-------------------------------------------------------------------------
+ */
+LOCAL pt_t *vh_pte(int pid, int p)
+{
+	unsigned long	vpno;
+	pd_t	*pd;
+
+	vpno = proctab[pid].vheap->vh_base / NBPG + p;
+	pd = (pd_t *) proctab[pid].pdbr + (vpno >> 10);
+	if (!pd->pd_pres)
+		return(NULL);
+	return((pt_t *) (pd->pd_base * NBPG) + (vpno & 0x3ff));
+}
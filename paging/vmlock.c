@@ -0,0 +1,150 @@
+/* vmlock.c - vmlock, vmunlock */
+
+#include <conf.h>
+#include <kernel.h>
+#include <proc.h>
+#include <paging.h>
+
+int	vm_nlocked = 0;			/* frames locked system-wide	*/
+
+LOCAL	fr_map_t *vml_frame(unsigned long vpno);
+LOCAL	void	vml_done(unsigned long, unsigned long, int);
+
+/*-------------------------------------------------------------------------
+ * vmlock - fault in the pages covering vaddr..vaddr+nbytes-1 and pin
+ *          them so that no replacement policy can evict them
+ *-------------------------------------------------------------------------
+ */
+SYSCALL vmlock(unsigned long vaddr, unsigned long nbytes)
+{
+	fr_map_t *fr;
+	unsigned long	vpno, first, last;
+	int	store, pageth, need;
+
+	if (nbytes == 0 || vaddr + nbytes < vaddr)
+		return(SYSERR);
+	first = vaddr / NBPG;
+	last = (vaddr + nbytes - 1) / NBPG;
+	if (first < 4096)		/* global pages are never evicted */
+		first = 4096;
+
+	pglock(PGL_BSM);
+	pglock(PGL_FRM);
+
+	/* every page must be mapped, and the new pins must fit the caps */
+	for (need = 0, vpno = first; vpno <= last; vpno++) {
+		if (bsm_lookup(currpid, vpno * NBPG, &store, &pageth) == SYSERR) {
+			pgunlock(PGL_FRM);
+			pgunlock(PGL_BSM);
+			return(SYSERR);
+		}
+		if ((fr = vml_frame(vpno)) == NULL || !(fr->fr_flags & FRF_LOCK))
+			need++;
+	}
+	if (proctab[currpid].plocked + need > NLOCKPROC ||
+	    vm_nlocked + need > NLOCKSYS) {
+		pgunlock(PGL_FRM);
+		pgunlock(PGL_BSM);
+		return(SYSERR);
+	}
+
+	/* pin each page as soon as it is in so later reads can't evict it */
+	for (vpno = first; vpno <= last; vpno++) {
+		if (prefetch_page(vpno * NBPG) == SYSERR ||
+		    (fr = vml_frame(vpno)) == NULL) {
+			vml_done(first, vpno, FALSE);
+			pgunlock(PGL_FRM);
+			pgunlock(PGL_BSM);
+			return(SYSERR);
+		}
+		if (fr->fr_flags & FRF_LOCK)
+			continue;
+		remove_pr_queue(fr - frm_tab);
+		fr->fr_flags = (fr->fr_flags & ~FRF_PREF) | FRF_LOCK |
+			FRF_NEWLK;
+		proctab[currpid].plocked++;
+		vm_nlocked++;
+	}
+	vml_done(first, last + 1, TRUE);
+
+	pgunlock(PGL_FRM);
+	pgunlock(PGL_BSM);
+	return(OK);
+}
+
+/*-------------------------------------------------------------------------
+ * vmunlock - make the pages covering vaddr..vaddr+nbytes-1 evictable
+ *-------------------------------------------------------------------------
+ */
+SYSCALL vmunlock(unsigned long vaddr, unsigned long nbytes)
+{
+	fr_map_t *fr;
+	unsigned long	vpno, first, last;
+	int	frameid;
+
+	if (nbytes == 0 || vaddr + nbytes < vaddr)
+		return(SYSERR);
+	first = vaddr / NBPG;
+	last = (vaddr + nbytes - 1) / NBPG;
+	if (first < 4096)		/* global pages are never pinned */
+		first = 4096;
+
+	pglock(PGL_FRM);
+	for (vpno = first; vpno <= last; vpno++) {
+		if ((fr = vml_frame(vpno)) == NULL || !(fr->fr_flags & FRF_LOCK))
+			continue;
+		fr->fr_flags &= ~FRF_LOCK;
+		frameid = fr - frm_tab;
+		append_pr_queue(&frameid);
+		proctab[currpid].plocked--;
+		vm_nlocked--;
+	}
+	pgunlock(PGL_FRM);
+	return(OK);
+}
+
+/*-------------------------------------------------------------------------
+ * vml_done - end a vmlock() call over pages first..end-1: keep the pins it
+ *            made, or undo them if it failed; PGL_FRM held
+ *-------------------------------------------------------------------------
+ */
+LOCAL void vml_done(unsigned long first, unsigned long end, int keep)
+{
+	fr_map_t *fr;
+	unsigned long	vpno;
+	int	frameid;
+
+	for (vpno = first; vpno < end; vpno++) {
+		if ((fr = vml_frame(vpno)) == NULL || !(fr->fr_flags & FRF_NEWLK))
+			continue;
+		fr->fr_flags &= ~FRF_NEWLK;
+		if (keep)
+			continue;
+		fr->fr_flags &= ~FRF_LOCK;
+		frameid = fr - frm_tab;
+		append_pr_queue(&frameid);
+		proctab[currpid].plocked--;
+		vm_nlocked--;
+	}
+}
+
+/*-------------------------------------------------------------------------
+ * vml_frame - frame holding page vpno of the current process, or NULL
+ *             if the page is not resident or the frame is not its own
+ *-------------------------------------------------------------------------
+ */
+LOCAL fr_map_t *vml_frame(unsigned long vpno)
+{
+	pd_t	*pd;
+	pt_t	*pt;
+
+	pd = (pd_t *) proctab[currpid].pdbr + (vpno >> 10);
+	if (!pd->pd_pres)
+		return(NULL);
+	pt = (pt_t *) (pd->pd_base * NBPG) + (vpno & 0x3ff);
+	if (!pt->pt_pres || pt->pt_base < FRAME0 ||
+	    pt->pt_base >= FRAME0 + NFRAMES ||
+	    frm_tab[pt->pt_base - FRAME0].fr_pid != currpid)
+		return(NULL);
+	return(&frm_tab[pt->pt_base - FRAME0]);
+}
@@ -0,0 +1,101 @@
+/* vmstat.c - vmhist_add, getvmstat, clrvmstat, vmstat_print */
+
+#include <conf.h>
+#include <kernel.h>
+#include <proc.h>
+#include <paging.h>
+#include <stdio.h>
+
+struct	vmstat	vmstat;		/* system-wide paging statistics	*/
+
+LOCAL	char	*vmh_name[NVMH] = { "fault", "get_frm", "pr_policy", "bs_io" };
+
+/*-------------------------------------------------------------------------
+ * vmhist_add - charge the cycles elapsed since t0 to latency histogram h
+ *-------------------------------------------------------------------------
+ */
+void vmhist_add(int h, unsigned long long t0)
+{
+	unsigned long long delta;
+	unsigned long	cyc;
+	int	bucket;
+
+	delta = read_tsc() - t0;
+	if (delta >> 32)
+		bucket = NVMHIST - 1;
+	else if ((cyc = (unsigned long) delta) <= 1)
+		bucket = 0;
+	else
+		asm("bsrl %1,%0" : "=r" (bucket) : "rm" (cyc));
+	vmstat.vs_hist[h][bucket]++;
+}
+
+/*-------------------------------------------------------------------------
+ * getvmstat - copy paging statistics for pid (or VMS_ALL) into *vs
+ *-------------------------------------------------------------------------
+ */
+SYSCALL getvmstat(int pid, struct vmstat *vs)
+{
+	STATWORD ps;
+	struct	pentry	*pptr;
+
+	if (vs == NULL)
+		return(SYSERR);
+	disable(ps);
+	if (pid == VMS_ALL) {
+		blkcopy(vs, &vmstat, sizeof(struct vmstat));
+		vs->vs_locked = vm_nlocked;
+		restore(ps);
+		return(OK);
+	}
+	if (isbadpid(pid) || (pptr = &proctab[pid])->pstate == PRFREE) {
+		restore(ps);
+		return(SYSERR);
+	}
+	/* histograms are kept system-wide only */
+	bzero(vs, sizeof(struct vmstat));
+	vs->vs_majflt = pptr->pmajflt;
+	vs->vs_minflt = pptr->pminflt;
+	vs->vs_evict = pptr->pevict;
+	vs->vs_wback = pptr->pwback;
+	vs->vs_prefhit = pptr->pprefhit;
+	vs->vs_locked = pptr->plocked;
+	restore(ps);
+	return(OK);
+}
+
+/*-------------------------------------------------------------------------
+ * clrvmstat - reset the system-wide paging statistics
+ *-------------------------------------------------------------------------
+ */
+SYSCALL clrvmstat(void)
+{
+	STATWORD ps;
+
+	disable(ps);
+	bzero(&vmstat, sizeof(vmstat));
+	restore(ps);
+	return(OK);
+}
+
+/*-------------------------------------------------------------------------
+ * vmstat_print - dump the system-wide statistics (monitor "v" command)
+ *-------------------------------------------------------------------------
+ */
+void vmstat_print(void)
+{
+	int	h, b;
+
+	kprintf("majflt %u minflt %u evict %u wback %u prefhit %u locked %d "
+		"protflt %u\n", vmstat.vs_majflt, vmstat.vs_minflt,
+		vmstat.vs_evict, vmstat.vs_wback, vmstat.vs_prefhit, vm_nlocked,
+		vmstat.vs_protflt);
+	for (h = 0; h < NVMH; h++) {
+		kprintf("%-9s", vmh_name[h]);
+		for (b = 0; b < NVMHIST; b++)
+			if (vmstat.vs_hist[h][b] != 0)
+				kprintf(" 2^%d:%u", b, vmstat.vs_hist[h][b]);
+		kprintf("\n");
+	}
+	pglock_print();
+}
@@ -0,0 +1,32 @@
+/* vsbrk.c - vsbrk */
+
+#include <conf.h>
+#include <kernel.h>
+#include <proc.h>
+#include <paging.h>
+
+/*------------------------------------------------------------------------
+ *  vsbrk  --  move the break of the private heap by nbytes, rounded to
+ *		pages, and return the old break.  Pages above the old
+ *		break are handed out by vgetmem(); only free pages can be
+ *		given back, and not while vmlock() pins them.  vsbrk(0)
+ *		returns the current break.
+ *------------------------------------------------------------------------
+ */
+WORD	*vsbrk(nbytes)
+	int	nbytes;
+{
+	struct	vheap	*vh;
+	WORD	*brk;
+	int	status;
+
+	if ((vh = proctab[currpid].vheap) == NULL) {
+		return( (WORD *)SYSERR );
+	}
+	brk = (WORD *)(vh->vh_base + (unsigned long)vh->vh_npages * NBPG);
+	if (nbytes >= 0)
+		status = vh_grow(currpid, (nbytes + NBPG - 1) / NBPG);
+	else
+		status = vh_shrink(currpid, (NBPG - 1 - nbytes) / NBPG);
+	return(status == SYSERR ? (WORD *)SYSERR : brk);
+}
@@ -0,0 +1,103 @@
+/* vstack.c - vstk_map, vstk_grow, vstk_exit */
+
+#include <conf.h>
+#include <kernel.h>
+#include <proc.h>
+#include <paging.h>
+#include <stdio.h>
+
+/*-------------------------------------------------------------------------
+ * vstk_map - give virtual stack page vpno of pid a zero-filled frame,
+ *            making its page table first if needed; return the frame.
+ *            The frame is owned by pid but kept off the replacement
+ *            queue.  Called with PGL_FRM held.
+ *-------------------------------------------------------------------------
+ */
+int vstk_map(int pid, unsigned long vpno)
+{
+	pd_t	*pde;
+	pt_t	*pte;
+	int	tf, pf;
+
+	pde = (pd_t *) proctab[pid].pdbr + (vpno >> 10);
+	if (!pde->pd_pres) {
+		if (get_frm(&tf) == SYSERR)
+			return(SYSERR);
+		frm_tab[tf].fr_status = FRM_MAPPED;
+		frm_tab[tf].fr_type = FR_TBL;
+		frm_tab[tf].fr_pid = pid;
+		frm_tab[tf].fr_refcnt = 0;
+		frm_tab[tf].fr_vpno = vpno & ~1023UL;
+		frm_tab[tf].fr_flags = 0;
+		frm_link(pid, tf);
+		bzero((char *) ((FRAME0 + tf) * NBPG), NBPG);
+		pde->pd_pres = 1;
+		pde->pd_write = 1;
+		pde->pd_base = FRAME0 + tf;
+		pft_cur.pt_flags |= PFT_NEWPT;
+	}
+	pte = (pt_t *) (pde->pd_base * NBPG) + (vpno & 1023);
+	if (pte->pt_pres)
+		return(pte->pt_base - FRAME0);
+
+	/* pin the table so get_frm() cannot evict it; an empty new table
+	   is freed with the rest when pid goes */
+	frm_tab[pde->pd_base - FRAME0].fr_refcnt++;
+	if (get_frm(&pf) == SYSERR) {
+		frm_tab[pde->pd_base - FRAME0].fr_refcnt--;
+		return(SYSERR);
+	}
+	if (rmap_add(pf, pid, pte) == SYSERR) {
+		frm_tab[pf].fr_status = FRM_UNMAPPED;
+		frm_tab[pf].fr_pid = -1;
+		frm_tab[pf].fr_vpno = 0;
+		frm_tab[pf].fr_flags = 0;
+		frm_tab[pde->pd_base - FRAME0].fr_refcnt--;
+		return(SYSERR);
+	}
+	frm_tab[pf].fr_status = FRM_MAPPED;
+	frm_tab[pf].fr_type = FR_PAGE;
+	frm_tab[pf].fr_pid = pid;
+	frm_tab[pf].fr_vpno = vpno;
+	frm_tab[pf].fr_flags = 0;
+	frm_link(pid, pf);
+	bzero((char *) ((FRAME0 + pf) * NBPG), NBPG);
+	pte->pt_pres = 1;
+	pte->pt_write = 1;
+	pte->pt_base = FRAME0 + pf;
+	return(pf);
+}
+
+/*-------------------------------------------------------------------------
+ * vstk_grow - back the virtual stack page of pid holding vaddr, which
+ *             must be inside the stack's reserve
+ *-------------------------------------------------------------------------
+ */
+int vstk_grow(int pid, unsigned long vaddr)
+{
+	int	frame;
+
+	if (vaddr < VSTK_BASE ||
+	    vaddr / NBPG < VSTK_TOPPG - proctab[pid].pvstk)
+		return(SYSERR);		/* the guard page or below	*/
+	pglock(PGL_FRM);
+	frame = vstk_map(pid, vaddr / NBPG);
+	pgunlock(PGL_FRM);
+	if (frame == SYSERR)
+		return(SYSERR);
+	pft_cur.pt_frame = frame;
+	return(OK);
+}
+
+/*-------------------------------------------------------------------------
+ * vstk_exit - finish kill() of the current process on the reserve
+ *             stack, since its own stack goes with its address space
+ *-------------------------------------------------------------------------
+ */
+void vstk_exit(int pid)
+{
+	asm volatile("movl %0, %%esp\n\t"
+		     "pushl %1\n\t"
+		     "call kill_reap"
+		     : : "r" (&pfrsvstk[NRSVSTK - 1]), "r" (pid));
+}
@@ -0,0 +1,52 @@
+/* vtrim.c - vtrim */
+
+#include <conf.h>
+#include <kernel.h>
+#include <proc.h>
+#include <paging.h>
+
+/*------------------------------------------------------------------------
+ *  vtrim  --  give back everything the private heap holds but doesn't
+ *		use: the empty page each size class keeps in reserve is
+ *		discarded, and the break drops to the highest page in use
+ *		or pinned so whole chunks above it return their backing
+ *		store
+ *------------------------------------------------------------------------
+ */
+SYSCALL	vtrim()
+{
+	struct	vheap	*vh;
+	struct	vhchunk	*vc;
+	int	c, p, s, next, prev, top;
+
+	if ((vh = proctab[currpid].vheap) == NULL) {
+		return(SYSERR);
+	}
+
+	/* empty class pages vfreemem() kept in reserve */
+	for (c = 0; c < NVHCLASS; c++)
+		for (p = vh->vh_partial[c]; p != -1; p = next) {
+			vc = VH_CHUNK(vh, p);
+			s = VH_SLOT(p);
+			next = vc->vc_next[s];
+			if (vc->vc_nfree[s] != NBPG / (VH_MINOBJ << c))
+				continue;
+			prev = vc->vc_prev[s];
+			if (prev != -1)
+				VH_CHUNK(vh, prev)->vc_next[VH_SLOT(prev)] = next;
+			else
+				vh->vh_partial[c] = next;
+			if (next != -1)
+				VH_CHUNK(vh, next)->vc_prev[VH_SLOT(next)] = prev;
+			vc->vc_next[s] = vc->vc_prev[s] = -1;
+			vh_pgfree(vh, p, 1);
+			vh_discard(currpid, p, 1);
+		}
+
+	for (top = vh->vh_npages; top > 0; top--)
+		if (VH_CHUNK(vh, top - 1)->vc_class[VH_SLOT(top - 1)] != VHC_FREE ||
+		    vh_pinned(currpid, top - 1))
+			break;
+	vh_shrink(currpid, vh->vh_npages - top);
+	return(OK);
+}
@@ -11,25 +11,26 @@ int write_bs(char *src, bsd_t bs_id, int page) {
      to the backing store bs_id, page
      page.
   */
-   STATWORD ps;
-   disable(ps);
+   pglock(PGL_BSM);
 
 // total number of backing stores = 8
    if (bs_id < 0 || bs_id >= 8){
-      restore(ps);
+      pgunlock(PGL_BSM);
       return SYSERR;
    }
 
-// total number of pages for each backing store = 128
-   if (page < 0 || page >= 128){
-      restore(ps);
+// total number of pages for each backing store = 256 (1 MB)
+   if (page < 0 || page >= 256){
+      pgunlock(PGL_BSM);
       return SYSERR;
    }
 
+   unsigned long long t0 = read_tsc();
    char * phy_addr = BACKING_STORE_BASE + bs_id*BACKING_STORE_UNIT_SIZE + page*NBPG;
    bcopy((void*)src, phy_addr, NBPG);
+   vmhist_add(VMH_BSIO, t0);
 
-   restore(ps);
+   pgunlock(PGL_BSM);
    return OK;
 
 }
\ No newline at end of file
@@ -7,6 +7,7 @@
 #define bs_check(bs_id) (bs_id < 0 || bs_id >= 8)
 #define virtno_check(virt_no) (virt_no < 4096)
 #define page_check(page_no) (page_no < 1 || page_no > 256)
+#define prot_check(prot) (((prot) & ~PROT_RW) || !(prot))
 
 
 /*-------------------------------------------------------------------------
@@ -15,26 +16,37 @@
  */
 SYSCALL xmmap(int virtpage, bsd_t source, int npages)
 {
-  STATWORD        ps;
-  disable(ps);
+  return xmmap_prot(virtpage, source, npages, PROT_RW);
+}
+
+
+/*-------------------------------------------------------------------------
+ * xmmap_prot - xmmap with PROT_READ (read-only) or PROT_RW protection
+ *-------------------------------------------------------------------------
+ */
+SYSCALL xmmap_prot(int virtpage, bsd_t source, int npages, int prot)
+{
+  pglock(PGL_BSM);
 
-  if(bs_check((int)source) || virtno_check(virtpage) || page_check(npages)){
-    restore(ps);
+  if(bs_check((int)source) || virtno_check(virtpage) || page_check(npages) ||
+     prot_check(prot)){
+    pgunlock(PGL_BSM);
     return SYSERR;
   }
 
   if(bsm_tab[source].bs_pvt_heap == 1){
-    restore(ps);
+    pgunlock(PGL_BSM);
     return SYSERR;
   }
 
   int bsm_map_status = bsm_map(currpid,virtpage,source,npages);
 	if (bsm_map_status == SYSERR){
-      restore(ps);
+      pgunlock(PGL_BSM);
       return SYSERR;
 	}	
   else{
-    restore(ps);
+    bsm_protect(source, 0, npages, prot);
+    pgunlock(PGL_BSM);
     return OK;
   }	
 
@@ -48,19 +60,153 @@ SYSCALL xmmap(int virtpage, bsd_t source, int npages)
  */
 SYSCALL xmunmap(int virtpage)
 {
-  STATWORD        ps;
-  disable(ps);
+  pglock(PGL_BSM);
 
 	if(!virtno_check(virtpage))
 	{
  	  int unmap_status = bsm_unmap(currpid,virtpage,0);
     if (unmap_status != SYSERR){
-      restore(ps);
+      write_cr3(proctab[currpid].pdbr);	/* flush the dropped pages */
+      pgunlock(PGL_BSM);
       return(OK);	
     }	
 	}
 
-	restore(ps);
+	pgunlock(PGL_BSM);
 	return SYSERR;
  
-}
\ No newline at end of file
+}
+
+/*-------------------------------------------------------------------------
+ * xmadvise - tell the pager how pages virtpage..virtpage+npages-1 of the
+ *            current process will be used.  SEQUENTIAL, RANDOM and NORMAL
+ *            are kept with every mapping the range touches; WILLNEED
+ *            reads the pages in now and DONTNEED discards their frames
+ *            without write-back, so their contents revert to the store.
+ *-------------------------------------------------------------------------
+ */
+SYSCALL xmadvise(int virtpage, int npages, int advice)
+{
+  int id, i, store, pageth, found = 0;
+  int lastpage = virtpage + npages;
+  pglock(PGL_BSM);
+  pglock(PGL_FRM);
+
+  if(virtno_check(virtpage) || npages < 1 ||
+     advice < MADV_NORMAL || advice > MADV_DONTNEED){
+    pgunlock(PGL_FRM);
+    pgunlock(PGL_BSM);
+    return SYSERR;
+  }
+
+  for(id = 0; id < 8; id++){
+    bs_map_t *bs_num = &bsm_tab[id];
+
+    if(bs_num->bs_status == BSM_MAPPED && bs_num->bs_pid == currpid &&
+       bs_num->bs_vpno < lastpage && virtpage < bs_num->bs_vpno + bs_num->bs_npages){
+      found = 1;
+      if(advice <= MADV_RANDOM)
+        bs_num->bs_advice = advice;
+    }
+  }
+  if(!found){
+    pgunlock(PGL_FRM);
+    pgunlock(PGL_BSM);
+    return SYSERR;
+  }
+
+  switch(advice){
+  case MADV_WILLNEED:
+    for(i = virtpage; i < lastpage; i++)
+      prefetch_page((unsigned long)i * NBPG);
+    break;
+
+  case MADV_DONTNEED:
+    for(i = 0; i < NFRAMES; i++){
+      if(frm_tab[i].fr_status == FRM_MAPPED && frm_tab[i].fr_type == FR_PAGE &&
+         frm_tab[i].fr_pid == currpid &&
+         frm_tab[i].fr_vpno >= virtpage && frm_tab[i].fr_vpno < lastpage)
+        drop_frm(i);
+    }
+    write_cr3(proctab[currpid].pdbr);   /* flush the dropped translations */
+    break;
+
+  default:
+    /* resident pages follow their region's new advice */
+    for(i = 0; i < NFRAMES; i++){
+      if(frm_tab[i].fr_status == FRM_MAPPED && frm_tab[i].fr_type == FR_PAGE &&
+         frm_tab[i].fr_pid == currpid &&
+         bsm_lookup(currpid, frm_tab[i].fr_vpno * NBPG, &store, &pageth) == OK){
+        if(bsm_tab[store].bs_advice == MADV_SEQUENTIAL)
+          frm_tab[i].fr_flags |= FRF_SEQ;
+        else
+          frm_tab[i].fr_flags &= ~FRF_SEQ;
+      }
+    }
+    break;
+  }
+
+  pgunlock(PGL_FRM);
+  pgunlock(PGL_BSM);
+  return OK;
+}
+
+
+/*-------------------------------------------------------------------------
+ * xmprotect - set the protection of pages virtpage..virtpage+npages-1
+ *             of the current process; every page must be mapped
+ *-------------------------------------------------------------------------
+ */
+SYSCALL xmprotect(int virtpage, int npages, int prot)
+{
+  int i, store, pageth;
+  pglock(PGL_BSM);
+  pglock(PGL_FRM);
+
+  if(virtno_check(virtpage) || npages < 1 || prot_check(prot)){
+    pgunlock(PGL_FRM);
+    pgunlock(PGL_BSM);
+    return SYSERR;
+  }
+
+  for(i = virtpage; i < virtpage + npages; i++){
+    if(bsm_lookup(currpid, (unsigned long)i * NBPG, &store, &pageth) == SYSERR){
+      pgunlock(PGL_FRM);
+      pgunlock(PGL_BSM);
+      return SYSERR;
+    }
+  }
+
+  for(i = virtpage; i < virtpage + npages; i++){
+    bsm_lookup(currpid, (unsigned long)i * NBPG, &store, &pageth);
+    bsm_protect(store, pageth, 1, prot);
+
+    /* resident pages change now; a write-protected dirty page keeps
+       its dirty bit and is still written back when evicted */
+    pd_t *pd_entry = (pd_t *)proctab[currpid].pdbr + (i >> 10);
+    if(pd_entry->pd_pres){
+      pt_t *pt_entry = (pt_t *)(pd_entry->pd_base * NBPG) + (i & 0x3ff);
+      if(pt_entry->pt_pres)
+        pt_entry->pt_write = (prot & PROT_WRITE) ? 1 : 0;
+    }
+  }
+  write_cr3(proctab[currpid].pdbr);   /* flush the old permissions */
+
+  pgunlock(PGL_FRM);
+  pgunlock(PGL_BSM);
+  return OK;
+}
+
+
+/*-------------------------------------------------------------------------
+ * vmprotect - xmprotect for the pages covering vaddr..vaddr+nbytes-1,
+ *             e.g. to write-protect a table once it is built
+ *-------------------------------------------------------------------------
+ */
+SYSCALL vmprotect(unsigned long vaddr, unsigned long nbytes, int prot)
+{
+  if(nbytes == 0 || vaddr + nbytes < vaddr)
+    return SYSERR;
+
+  return xmprotect(vaddr / NBPG, (vaddr + nbytes - 1) / NBPG - vaddr / NBPG + 1, prot);
+}
@@ -0,0 +1,12 @@
+/* conf.h - stand-in for the generated conf.h when building pgsim */
+
+#define	NULLPTR	(char *)0
+
+struct	devsw;
+
+#define	NDEVS	0
+
+#define	NPROC	    50			/* number of user processes	*/
+#define	NSEM	    100			/* number of semaphores		*/
+
+#define	isbaddev(f)	1
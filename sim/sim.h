@@ -0,0 +1,36 @@
+/* sim.h - interface between the pgsim driver and the simulated kernel */
+
+/* simkern.c is compiled against the Xinu headers and the paging/	*/
+/* sources; simmain.c is compiled against the host C library.  The two	*/
+/* halves only share the declarations below.				*/
+
+#define SIM_PHYSBASE	0x00400000	/* FRAME0 * NBPG		*/
+#define SIM_PHYSLEN	0x00c00000	/* frames and backing stores	*/
+
+#define SIM_NSTORES	8		/* backing stores		*/
+#define SIM_STOREPAGES	256		/* pages per backing store	*/
+#define SIM_MINVPNO	4096		/* lowest mappable page		*/
+
+#define SIM_NORMAL	0		/* paging.h MADV_* values	*/
+#define SIM_SEQUENTIAL	1
+#define SIM_RANDOM	2
+
+struct simstats {
+	unsigned long	ss_faults;	/* major + minor faults		*/
+	unsigned long	ss_evict;	/* frames taken by pr_policy()	*/
+	unsigned long	ss_wback;	/* pages written back		*/
+	unsigned long	ss_bsread;	/* pages read from stores	*/
+	unsigned long	ss_prefhit;	/* read-ahead pages referenced	*/
+};
+
+extern	int	sim_npolicy;		/* policies known to the kernel	*/
+extern	char	*sim_polname[];
+extern	int	sim_polid[];
+extern	int	sim_nframes;		/* NFRAMES			*/
+
+void	sim_reset(int policy, int nframes);
+int	sim_newproc(int pid);
+int	sim_map(int pid, int vpno, int store, int npages);
+void	sim_advise(int advice);
+int	sim_ref(int pid, unsigned long vaddr, int write);
+void	sim_stats(struct simstats *ss);
@@ -0,0 +1,222 @@
+/* simkern.c - kernel half of pgsim: globals, stubs and a software MMU */
+
+#include <conf.h>
+#include <i386.h>
+#include <kernel.h>
+#include <proc.h>
+#include <paging.h>
+#include "sim.h"
+
+/* kernel variables normally defined by initialize.c and friends */
+struct	pentry	proctab[NPROC];
+int	currpid;
+bool	debug_option = false;
+int	pr_qhead = -1;
+int	pr_qtail = -1;
+int	page_replace_policy = SC;
+bs_map_t bsm_tab[8];
+fr_map_t frm_tab[NFRAMES];
+pr_queue pr_qtab[NFRAMES];
+struct	vmstat	vmstat;
+struct	pftrec	pft_cur;
+int	pft_enabled;
+unsigned long pferrcode;
+int	vm_nlocked;
+struct	tss	i386_tasks[2];
+
+int	sim_npolicy = 2;
+char	*sim_polname[] = { "SC", "AGING" };
+int	sim_polid[] = { SC, AGING };
+int	sim_nframes = NFRAMES;
+
+LOCAL	unsigned long	sim_cr2;	/* faulting address for pfint	*/
+LOCAL	unsigned long	sim_bsread;	/* pages read from the stores	*/
+
+/*------------------------------------------------------------------------
+ * hardware and kernel services the paging code expects
+ *------------------------------------------------------------------------
+ */
+int disable(short *ps) { return(OK); }
+int restore(short *ps) { return(OK); }
+void pglock(int l) { }
+void pgunlock(int l) { }
+unsigned long read_cr2(void) { return(sim_cr2); }
+void write_cr3(unsigned long n) { }
+unsigned long long read_tsc(void) { return(0); }
+void vmhist_add(int h, unsigned long long t0) { }
+void pftrace_log(void) { }
+SYSCALL kill(int pid) { return(OK); }
+int set_evec(u_int xnum, u_long handler) { return(OK); }
+int set_tvec(u_int xnum, u_short tss) { return(OK); }
+void pfintr(void) { }
+void fpuintr(void) { }
+int vstk_grow(int pid, unsigned long vaddr) { return(SYSERR); }
+
+/*------------------------------------------------------------------------
+ * read_bs, write_bs - simulated backing store at BACKING_STORE_BASE
+ *------------------------------------------------------------------------
+ */
+SYSCALL read_bs(char *dst, bsd_t bs_id, int page)
+{
+	if (bs_id >= SIM_NSTORES || page < 0 || page >= SIM_STOREPAGES)
+		return(SYSERR);
+	__builtin_memcpy(dst, (char *) (BACKING_STORE_BASE +
+		bs_id * BACKING_STORE_UNIT_SIZE + page * NBPG), NBPG);
+	sim_bsread++;
+	return(OK);
+}
+
+SYSCALL write_bs(char *src, bsd_t bs_id, int page)
+{
+	if (bs_id >= SIM_NSTORES || page < 0 || page >= SIM_STOREPAGES)
+		return(SYSERR);
+	__builtin_memcpy((char *) (BACKING_STORE_BASE +
+		bs_id * BACKING_STORE_UNIT_SIZE + page * NBPG), src, NBPG);
+	return(OK);
+}
+
+/*------------------------------------------------------------------------
+ * sim_reset - bring the paging state to what sysinit() leaves behind
+ *------------------------------------------------------------------------
+ */
+void sim_reset(int policy, int nframes)
+{
+	pt_t	*pt;
+	int	i, j, frameid;
+
+	__builtin_memset(proctab, 0, sizeof(proctab));
+	for (i = 0; i < NPROC; i++)
+		proctab[i].pfrhead = -1;
+	__builtin_memset(&vmstat, 0, sizeof(vmstat));
+	__builtin_memset((char *) SIM_PHYSBASE, 0, SIM_PHYSLEN);
+	sim_bsread = 0;
+	pr_qhead = pr_qtail = -1;
+	page_replace_policy = policy;
+	backing_store_map();
+	frame_table_map();
+	init_page_replace();
+
+	/* global page tables for the first 16 MB, as in sysinit() */
+	for (i = 0; i < 4; i++) {
+		get_frm(&frameid);
+		frm_tab[frameid].fr_status = FRM_MAPPED;
+		frm_tab[frameid].fr_type = FR_TBL;
+		frm_tab[frameid].fr_pid = NULLPROC;
+		pt = (pt_t *) ((unsigned long) (FRAME0 + frameid) * NBPG);
+		for (j = 0; j < 1024; j++, pt++) {
+			pt->pt_pres = 1;
+			pt->pt_write = 1;
+			pt->pt_global = 1;
+			pt->pt_base = i * FRAME0 + j;
+		}
+	}
+	if (sim_newproc(NULLPROC) == SYSERR)
+		return;
+	currpid = NULLPROC;
+
+	/* frames beyond the simulated memory size are never handed out */
+	for (i = nframes; i < NFRAMES; i++) {
+		frm_tab[i].fr_status = FRM_MAPPED;
+		frm_tab[i].fr_type = FR_TBL;
+		frm_tab[i].fr_pid = NULLPROC;
+	}
+}
+
+/*------------------------------------------------------------------------
+ * sim_newproc - give pid a page directory, as create() does
+ *------------------------------------------------------------------------
+ */
+int sim_newproc(int pid)
+{
+	pd_t	*pd;
+	int	i, frameid;
+
+	if (pid < 0 || pid >= NPROC || get_frm(&frameid) == SYSERR)
+		return(SYSERR);
+	proctab[pid].pstate = PRSUSP;
+	proctab[pid].pdbr = (unsigned long) (FRAME0 + frameid) * NBPG;
+	frm_tab[frameid].fr_status = FRM_MAPPED;
+	frm_tab[frameid].fr_type = FR_DIR;
+	frm_tab[frameid].fr_pid = pid;
+	proctab[pid].pfrhead = -1;
+	frm_link(pid, frameid);
+	pd = (pd_t *) proctab[pid].pdbr;
+	for (i = 0; i < 1024; i++) {
+		pd[i].pd_write = 1;
+		if (i < 4) {
+			pd[i].pd_pres = 1;
+			pd[i].pd_base = FRAME0 + i;
+		}
+	}
+	return(OK);
+}
+
+/*------------------------------------------------------------------------
+ * sim_map - map npages of store at vpno for pid, as xmmap() does
+ *------------------------------------------------------------------------
+ */
+int sim_map(int pid, int vpno, int store, int npages)
+{
+	return(bsm_map(pid, vpno, store, npages));
+}
+
+/*------------------------------------------------------------------------
+ * sim_advise - set the xmadvise() hint of every mapped store
+ *------------------------------------------------------------------------
+ */
+void sim_advise(int advice)
+{
+	int	i;
+
+	for (i = 0; i < SIM_NSTORES; i++)
+		if (bsm_tab[i].bs_status == BSM_MAPPED)
+			bsm_tab[i].bs_advice = advice;
+}
+
+/*------------------------------------------------------------------------
+ * sim_ref - one memory reference: walk the tables, fault, set A/D bits
+ *------------------------------------------------------------------------
+ */
+int sim_ref(int pid, unsigned long vaddr, int write)
+{
+	pd_t	*pd;
+	pt_t	*pt;
+	int	faulted = 0;
+
+	currpid = pid;
+	pd = (pd_t *) proctab[pid].pdbr + (vaddr >> 22);
+	if (!pd->pd_pres || !(pt = (pt_t *) ((unsigned long) pd->pd_base *
+	    NBPG) + ((vaddr >> 12) & 0x3ff))->pt_pres) {
+		sim_cr2 = vaddr;
+		pferrcode = write ? 2 : 0;	/* not-present fault	*/
+		pfint();
+		faulted = 1;
+		pt = (pt_t *) ((unsigned long) pd->pd_base * NBPG) +
+			((vaddr >> 12) & 0x3ff);
+		if (!pd->pd_pres || !pt->pt_pres)
+			return(SYSERR);
+	}
+	if (write && !pt->pt_write) {
+		sim_cr2 = vaddr;
+		pferrcode = 3;			/* protection fault	*/
+		pfint();
+		return(SYSERR);
+	}
+	pt->pt_acc = 1;
+	if (write)
+		pt->pt_dirty = 1;
+	return(faulted);
+}
+
+/*------------------------------------------------------------------------
+ * sim_stats - report what the kernel counted since sim_reset()
+ *------------------------------------------------------------------------
+ */
+void sim_stats(struct simstats *ss)
+{
+	ss->ss_faults = vmstat.vs_majflt + vmstat.vs_minflt;
+	ss->ss_evict = vmstat.vs_evict;
+	ss->ss_wback = vmstat.vs_wback;
+	ss->ss_bsread = sim_bsread;
+	ss->ss_prefhit = vmstat.vs_prefhit;
+}
@@ -0,0 +1,447 @@
+/* simmain.c - pgsim: replay address traces against the paging code */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <math.h>
+#include <time.h>
+#include <sys/mman.h>
+#include "sim.h"
+
+/*
+ * usage: pgsim [-f frames] [-p policy] [-t trace | -g pattern]
+ *		[-n refs] [-s pages] [-w write%] [-z skew] [-S seed]
+ *		[-a normal|seq|rand]
+ *
+ * A trace is either a pftrace_dump() capture (binary frames, detected
+ * by PFT_FLAG) or text with one reference per line: "[pid] r|w addr".
+ * Patterns: seq, rand, stride, zipf, loop.  Every policy known to the
+ * kernel is run on the same reference string (or just -p), followed by
+ * Belady's OPT over the frames left for pages, and each run prints one
+ * "key=value" line.  -a applies an xmadvise() hint to every store.
+ */
+
+#define PFT_FLAG	0x7e		/* must match paging.h		*/
+#define PFT_ESC		0x7d
+#define PFT_REC		'R'
+#define PFT_RECSIZE	32
+
+struct	ref	{
+	unsigned int	r_vaddr;
+	short		r_pid;
+	short		r_write;
+};
+
+static	struct	ref	*refs;
+static	long	nrefs, maxrefs;
+
+/*------------------------------------------------------------------------
+ * kprintf - the paging code's console output goes to stdout
+ *------------------------------------------------------------------------
+ */
+int kprintf(char *fmt, ...)
+{
+	va_list	ap;
+
+	va_start(ap, fmt);
+	vprintf(fmt, ap);
+	va_end(ap);
+	return 1;
+}
+
+static void die(char *msg)
+{
+	fprintf(stderr, "pgsim: %s\n", msg);
+	exit(1);
+}
+
+static void addref(int pid, unsigned long vaddr, int write)
+{
+	if (nrefs == maxrefs) {
+		maxrefs = maxrefs ? 2 * maxrefs : 65536;
+		if ((refs = realloc(refs, maxrefs * sizeof(*refs))) == NULL)
+			die("out of memory");
+	}
+	refs[nrefs].r_vaddr = vaddr;
+	refs[nrefs].r_pid = pid;
+	refs[nrefs].r_write = write;
+	nrefs++;
+}
+
+/*------------------------------------------------------------------------
+ * load_dump - decode pftrace_dump() frames; each fault is one reference
+ *------------------------------------------------------------------------
+ */
+static void load_dump(unsigned char *buf, long len)
+{
+	unsigned char	frame[64], sum;
+	long	i;
+	int	n, esc, k;
+
+	for (i = 0; i < len; i++) {
+		if (buf[i] != PFT_FLAG)
+			continue;
+		for (n = esc = 0, i++; i < len && buf[i] != PFT_FLAG; i++) {
+			if (buf[i] == PFT_ESC) {
+				esc = 1;
+				continue;
+			}
+			if (n < (int) sizeof(frame))
+				frame[n++] = esc ? buf[i] ^ 0x20 : buf[i];
+			esc = 0;
+		}
+		i--;			/* closing flag may open the next */
+		for (sum = 0, k = 0; k < n; k++)
+			sum += frame[k];
+		if (n != PFT_RECSIZE + 2 || frame[0] != PFT_REC || sum != 0)
+			continue;
+		addref(frame[17] | frame[18] << 8,
+			frame[9] | frame[10] << 8 | frame[11] << 16 |
+			(unsigned long) frame[12] << 24,
+			(frame[13] & 2) != 0);
+	}
+}
+
+/*------------------------------------------------------------------------
+ * load_trace - read a trace file in either format
+ *------------------------------------------------------------------------
+ */
+static void load_trace(char *path)
+{
+	FILE	*fp;
+	unsigned char	*buf;
+	long	len;
+	char	*line, *p, *end;
+	int	pid, write;
+
+	if ((fp = fopen(path, "rb")) == NULL)
+		die("cannot open trace");
+	fseek(fp, 0, SEEK_END);
+	len = ftell(fp);
+	rewind(fp);
+	if ((buf = malloc(len + 1)) == NULL ||
+	    fread(buf, 1, len, fp) != (size_t) len)
+		die("cannot read trace");
+	fclose(fp);
+	buf[len] = '\0';
+
+	if (memchr(buf, PFT_FLAG, len) != NULL) {
+		load_dump(buf, len);
+		free(buf);
+		return;
+	}
+	for (line = strtok((char *) buf, "\n"); line != NULL;
+	     line = strtok(NULL, "\n")) {
+		pid = 1;
+		write = 0;
+		for (p = line; *p == ' ' || *p == '\t'; p++)
+			;
+		if (*p == '#' || *p == '\0')
+			continue;
+		if (*p >= '0' && *p <= '9' && strchr(p, ' ') != NULL &&
+		    strncmp(p, "0x", 2) != 0) {
+			pid = strtol(p, &end, 10);
+			for (p = end; *p == ' ' || *p == '\t'; p++)
+				;
+		}
+		if (*p == 'r' || *p == 'w' || *p == 'R' || *p == 'W') {
+			write = (*p == 'w' || *p == 'W');
+			for (p++; *p == ' ' || *p == '\t'; p++)
+				;
+		}
+		addref(pid, strtoul(p, NULL, 0), write);
+	}
+	free(buf);
+}
+
+/*------------------------------------------------------------------------
+ * gen_pattern - synthesize nref references over npages pages
+ *------------------------------------------------------------------------
+ */
+static void gen_pattern(char *pat, long nref, int npages, int wpct,
+	double skew)
+{
+	unsigned long	base = (unsigned long) SIM_MINVPNO * 4096;
+	double	*cdf = NULL, u, tot;
+	long	i;
+	int	page = 0, lo, hi, mid;
+
+	if (strcmp(pat, "zipf") == 0) {
+		if ((cdf = malloc(npages * sizeof(double))) == NULL)
+			die("out of memory");
+		for (tot = 0, i = 0; i < npages; i++)
+			cdf[i] = (tot += 1.0 / pow(i + 1, skew));
+		for (i = 0; i < npages; i++)
+			cdf[i] /= tot;
+	}
+	for (i = 0; i < nref; i++) {
+		if (strcmp(pat, "seq") == 0)
+			page = (i / 16) % npages;	/* 16 refs a page */
+		else if (strcmp(pat, "loop") == 0)
+			page = i % npages;
+		else if (strcmp(pat, "stride") == 0)
+			page = (i * 7) % npages;
+		else if (strcmp(pat, "rand") == 0)
+			page = random() % npages;
+		else if (cdf != NULL) {
+			u = (double) random() / RAND_MAX;
+			for (lo = 0, hi = npages - 1; lo < hi; ) {
+				mid = (lo + hi) / 2;
+				if (cdf[mid] < u)
+					lo = mid + 1;
+				else
+					hi = mid;
+			}
+			page = lo;
+		} else
+			die("unknown pattern");
+		addref(1, base + (unsigned long) page * 4096 +
+			(i * 64) % 4096, (random() % 100) < wpct);
+	}
+	free(cdf);
+}
+
+/*------------------------------------------------------------------------
+ * map_refs - create the processes and back every touched 256-page chunk
+ *------------------------------------------------------------------------
+ */
+static int chunks[SIM_NSTORES][2];	/* pid, first vpno		*/
+static int nchunks, npids, pids[64];
+
+static void find_chunks(void)
+{
+	long	i;
+	int	k, pid, vpno;
+
+	for (i = 0; i < nrefs; i++) {
+		pid = refs[i].r_pid;
+		vpno = (refs[i].r_vaddr >> 12) & ~(SIM_STOREPAGES - 1);
+		if ((refs[i].r_vaddr >> 12) < SIM_MINVPNO)
+			die("reference below the first mappable page");
+		for (k = 0; k < nchunks; k++)
+			if (chunks[k][0] == pid && chunks[k][1] == vpno)
+				break;
+		if (k == nchunks) {
+			if (nchunks == SIM_NSTORES)
+				die("trace needs more than 8 backing stores");
+			chunks[nchunks][0] = pid;
+			chunks[nchunks++][1] = vpno;
+		}
+		for (k = 0; k < npids && pids[k] != pid; k++)
+			;
+		if (k == npids) {
+			if (npids == 64 || pid <= 0)
+				die("bad process id in trace");
+			pids[npids++] = pid;
+		}
+	}
+}
+
+static void map_refs(void)
+{
+	int	k;
+
+	for (k = 0; k < npids; k++)
+		if (sim_newproc(pids[k]) < 0)
+			die("cannot create process");
+	for (k = 0; k < nchunks; k++)
+		if (sim_map(chunks[k][0], chunks[k][1], k, SIM_STOREPAGES) < 0)
+			die("cannot map backing store");
+}
+
+/*------------------------------------------------------------------------
+ * opt_faults - Belady's MIN with cap frames, via next-use and a max-heap
+ *------------------------------------------------------------------------
+ */
+struct	hent	{ long h_next; unsigned long h_key; };
+
+static unsigned long refkey(long i)
+{
+	return (unsigned long) refs[i].r_pid << 20 | refs[i].r_vaddr >> 12;
+}
+
+static long opt_faults(int cap)
+{
+	long	*next, *seen, i, faults = 0, hsize = 1, nres = 0;
+	unsigned long	*keys, k;
+	struct	hent	*heap, t;
+	char	*res;
+	long	c, p, slot;
+
+	while (hsize < 2 * nrefs)
+		hsize <<= 1;
+	next = malloc(nrefs * sizeof(long));
+	seen = malloc(hsize * sizeof(long));
+	keys = malloc(hsize * sizeof(unsigned long));
+	res = calloc(hsize, 1);
+	heap = malloc((nrefs + 1) * sizeof(struct hent));
+	if (!next || !seen || !keys || !res || !heap)
+		die("out of memory");
+	memset(seen, -1, hsize * sizeof(long));
+
+	/* next[i]: index of the next reference to the same page */
+	for (i = nrefs - 1; i >= 0; i--) {
+		k = refkey(i);
+		for (slot = (k * 2654435761UL) & (hsize - 1);
+		     seen[slot] != -1 && keys[slot] != k;
+		     slot = (slot + 1) & (hsize - 1))
+			;
+		next[i] = seen[slot] == -1 ? nrefs : seen[slot];
+		keys[slot] = k;
+		seen[slot] = i;
+	}
+
+	/* resident pages sit in a max-heap keyed by next use; stale	*/
+	/* entries (a page re-pushed after a hit) are dropped lazily	*/
+	for (i = 0, c = 0; i < nrefs; i++) {
+		k = refkey(i);
+		for (slot = (k * 2654435761UL) & (hsize - 1); keys[slot] != k;
+		     slot = (slot + 1) & (hsize - 1))
+			;
+		if (!res[slot]) {
+			faults++;
+			if (nres == cap) {
+				for (;;) {	/* pop the farthest page */
+					t = heap[1];
+					heap[1] = heap[c--];
+					for (p = 1; 2 * p <= c; p = slot) {
+						slot = 2 * p;
+						if (slot < c && heap[slot + 1].h_next >
+						    heap[slot].h_next)
+							slot++;
+						if (heap[p].h_next >= heap[slot].h_next)
+							break;
+						struct hent x = heap[p];
+						heap[p] = heap[slot];
+						heap[slot] = x;
+					}
+					for (slot = (t.h_key * 2654435761UL) &
+					     (hsize - 1); keys[slot] != t.h_key;
+					     slot = (slot + 1) & (hsize - 1))
+						;
+					if (res[slot] && seen[slot] == t.h_next)
+						break;
+				}
+				res[slot] = 0;
+				nres--;
+				for (slot = (k * 2654435761UL) & (hsize - 1);
+				     keys[slot] != k; slot = (slot + 1) & (hsize - 1))
+					;
+			}
+			res[slot] = 1;
+			nres++;
+		}
+		seen[slot] = next[i];		/* current next use	*/
+		heap[++c].h_next = next[i];	/* push, sift up	*/
+		heap[c].h_key = k;
+		for (p = c; p > 1 && heap[p / 2].h_next < heap[p].h_next;
+		     p /= 2) {
+			t = heap[p];
+			heap[p] = heap[p / 2];
+			heap[p / 2] = t;
+		}
+	}
+	free(next); free(seen); free(keys); free(res); free(heap);
+	return faults;
+}
+
+int main(int argc, char *argv[])
+{
+	char	*trace = NULL, *pattern = "zipf", *policy = NULL;
+	int	advice = SIM_NORMAL;
+	int	nframes = sim_nframes, npages = 1536, wpct = 30, i, ntables;
+	long	nref = 2000000, j, bad;
+	double	skew = 0.9, secs;
+	unsigned long	tab[SIM_NSTORES * 64][2];
+	struct	simstats ss;
+	struct	timespec t0, t1;
+
+	for (i = 1; i < argc; i++) {
+		if (argv[i][0] != '-' || argv[i][2] != '\0' || i + 1 == argc)
+			die("usage: pgsim [-f frames] [-p policy] [-t trace | "
+			    "-g pattern] [-n refs] [-s pages] [-w write%] "
+			    "[-z skew] [-S seed] [-a advice]");
+		switch (argv[i][1]) {
+		case 'f': nframes = atoi(argv[++i]); break;
+		case 'p': policy = argv[++i]; break;
+		case 't': trace = argv[++i]; break;
+		case 'g': pattern = argv[++i]; break;
+		case 'n': nref = atol(argv[++i]); break;
+		case 's': npages = atoi(argv[++i]); break;
+		case 'w': wpct = atoi(argv[++i]); break;
+		case 'z': skew = atof(argv[++i]); break;
+		case 'S': srandom(atoi(argv[++i])); break;
+		case 'a':
+			i++;
+			if (strcmp(argv[i], "seq") == 0)
+				advice = SIM_SEQUENTIAL;
+			else if (strcmp(argv[i], "rand") == 0)
+				advice = SIM_RANDOM;
+			else if (strcmp(argv[i], "normal") != 0)
+				die("unknown advice");
+			break;
+		default:  die("unknown option");
+		}
+	}
+	if (nframes < 16 || nframes > sim_nframes)
+		die("frame count out of range");
+	if (npages < 1 || npages > SIM_NSTORES * SIM_STOREPAGES)
+		die("page count out of range");
+	if (mmap((void *) SIM_PHYSBASE, SIM_PHYSLEN, PROT_READ | PROT_WRITE,
+	    MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0) !=
+	    (void *) SIM_PHYSBASE)
+		die("cannot map simulated physical memory");
+
+	if (trace != NULL) {
+		load_trace(trace);
+		pattern = "trace";
+	} else
+		gen_pattern(pattern, nref, npages, wpct, skew);
+	if (nrefs == 0)
+		die("no references");
+	find_chunks();
+
+	for (i = 0; i < sim_npolicy; i++) {
+		if (policy != NULL && strcasecmp(policy, sim_polname[i]) != 0)
+			continue;
+		sim_reset(sim_polid[i], nframes);
+		map_refs();
+		sim_advise(advice);
+		clock_gettime(CLOCK_MONOTONIC, &t0);
+		for (bad = 0, j = 0; j < nrefs; j++)
+			if (sim_ref(refs[j].r_pid, refs[j].r_vaddr,
+			    refs[j].r_write) < 0)
+				bad++;
+		clock_gettime(CLOCK_MONOTONIC, &t1);
+		secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+		sim_stats(&ss);
+		printf("pgsim policy=%s pattern=%s frames=%d refs=%ld "
+		    "faults=%lu fault_rate=%.6f evict=%lu wback=%lu "
+		    "bsread=%lu prefhit=%lu unresolved=%ld mrefs_per_s=%.2f\n",
+		    sim_polname[i], pattern, nframes, nrefs, ss.ss_faults,
+		    (double) ss.ss_faults / nrefs, ss.ss_evict, ss.ss_wback,
+		    ss.ss_bsread, ss.ss_prefhit, bad, nrefs / secs / 1e6);
+	}
+
+	/* OPT gets the frames that are left once the global tables, the */
+	/* directories and one table per 4 MB touched are accounted for	 */
+	for (ntables = 0, j = 0; j < nrefs; j++) {
+		for (i = 0; i < ntables; i++)
+			if (tab[i][0] == (unsigned long) refs[j].r_pid &&
+			    tab[i][1] == refs[j].r_vaddr >> 22)
+				break;
+		if (i == ntables && ntables < SIM_NSTORES * 64) {
+			tab[ntables][0] = refs[j].r_pid;
+			tab[ntables++][1] = refs[j].r_vaddr >> 22;
+		}
+	}
+	i = nframes - 5 - npids - ntables;
+	if (i > 0) {
+		long f = opt_faults(i);
+		printf("pgsim policy=OPT pattern=%s frames=%d refs=%ld "
+		    "faults=%ld fault_rate=%.6f page_frames=%d\n",
+		    pattern, nframes, nrefs, f, (double) f / nrefs, i);
+	}
+	return 0;
+}
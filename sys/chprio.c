@@ -3,6 +3,8 @@
 #include <conf.h>
 #include <kernel.h>
 #include <proc.h>
+#include <q.h>
+#include <mutex.h>
 
 /*------------------------------------------------------------------------
  * chprio  --  change the scheduling priority of a process
@@ -17,16 +19,16 @@ SYSCALL chprio(pid,newprio)
 	struct	pentry	*pptr;
 
 	disable(ps);
-	if (isbadpid(pid) || newprio<=0 ||
+	if (isbadpid(pid) || newprio<=0 || newprio>MAXPRIO ||
 	    (pptr = &proctab[pid])->pstate == PRFREE) {
 		restore(ps);
 		return(SYSERR);
 	}
-	oldprio = pptr->pprio;
-	pptr->pprio = newprio;
+	oldprio = pptr->pbprio;
+	pptr->pbprio = newprio;
+	minherit(pid);			/* pprio, and the queue it is on */
 	switch (pptr->pstate) {
 	case PRREADY:
-		insert( dequeue(pid), rdyhead, newprio);
 	case PRCURR:
 		resched();
 	default:
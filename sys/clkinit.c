@@ -6,13 +6,8 @@
 #include <i386.h>
 #include <stdio.h>
 #include <q.h>
+#include <timer.h>
 
-/* Intel 8254-2 clock chip constants */
-
-#define	CLOCKBASE	0x40		/* I/O base port of clock chip	*/
-#define	CLOCK0		CLOCKBASE
-#define	CLKCNTL		(CLOCKBASE+3)	/* chip CSW I/O port		*/
-    
 /* real-time clock variables and sleeping process queue pointers	*/
     
 #ifdef	RTCLOCK
@@ -23,10 +18,8 @@ unsigned long clktime = 0;	/* current time in seconds since 1/1/70	*/
 int	clmutex;		/* mutual exclusion for time-of-day	*/
 int     defclk;			/* non-zero, then deferring clock count */
 int     clkdiff;		/* deferred clock ticks			*/
-int     slnempty;		/* FALSE if the sleep queue is empty	*/
-int     *sltop;			/* address of key part of top entry in	*/
-				/* the sleep queue if slnonempty==TRUE	*/
-int     clockq;			/* head of queue of sleeping processes  */
+int     slnempty;		/* processes on the timing wheel, 0 if	*/
+				/* none (see wheel.c)			*/
 int	preempt;		/* preemption counter.	Current process */
 				/* is preempted when it reaches zero;	*/
 #ifdef	RTCLOCK
@@ -49,10 +42,10 @@ void clkinit()
 	set_evec(IRQBASE, (u_long)clkint);
 
 	/* clock rate is 1.190 Mhz; this is 10ms interrupt rate */
-	intv = 1190;
+	intv = CLKCOUNTS;
 
 	clkruns = 1;
-	clockq = newqueue();
+	twinit();
 	preempt = QUANTUM;		/* initial time quantum		*/
 	clmutex = screate(1);
 
@@ -63,6 +56,9 @@ void clkinit()
 	outb(CLOCK0, (char)intv);
 	outb(CLOCK0, intv>>8);
 	outb(CLOCK0, intv>>8);
+
+	tminit();
+	tscinit();			/* times the ticks just started	*/
 }
 #endif
 
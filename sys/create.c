@@ -1,4 +1,4 @@
-/* create.c - create, newpid */
+/* create.c - create, mkproc, newpid */
     
 #include <conf.h>
 #include <i386.h>
@@ -18,11 +18,24 @@ LOCAL int newpid();
 SYSCALL create(procaddr,ssize,priority,name,nargs,args)
 	int	*procaddr;		/* procedure address		*/
 	int	ssize;			/* stack size in words		*/
-	int	priority;		/* process priority > 0		*/
+	int	priority;		/* 0 < priority <= MAXPRIO	*/
 	char	*name;			/* name (for debugging)		*/
 	int	nargs;			/* number of args that follow	*/
 	long	args;			/* arguments (treated like an	*/
 					/* array in the code)		*/
+{
+	return(mkproc(procaddr, ssize, priority, name, nargs,
+		(unsigned long *)&args, FALSE));
+}
+
+/*------------------------------------------------------------------------
+ *  mkproc  -  create a process whose nargs arguments are at argv; with
+ *	       vstk its stack is placed in its own address space (see
+ *	       vcreate) instead of being taken from the kernel heap
+ *------------------------------------------------------------------------
+ */
+SYSCALL mkproc(int *procaddr, int ssize, int priority, char *name,
+	int nargs, unsigned long *argv, int vstk)
 {
 	unsigned long	savsp, *pushsp;
 	STATWORD 	ps;    
@@ -31,6 +44,9 @@ SYSCALL create(procaddr,ssize,priority,name,nargs,args)
 	int		i;
 	unsigned long	*a;		/* points to list of args	*/
 	unsigned long	*saddr;		/* stack address		*/
+	unsigned long	sdelta;		/* stack's address in use less	*/
+					/* the one it is built through	*/
+	int		npages;		/* virtual stack reserve	*/
 	int		INITRET();
 	
 	pd_t *pgdir_entry;
@@ -41,13 +57,68 @@ SYSCALL create(procaddr,ssize,priority,name,nargs,args)
 	if (ssize < MINSTK)
 		ssize = MINSTK;
 	ssize = (int) roundew(ssize);
-	if (((saddr = (unsigned long *)getstk(ssize)) ==
-	    (unsigned long *)SYSERR ) ||
-	    (pid=newpid()) == SYSERR || priority < 1 ) {
+	npages = vstk ? (ssize + NBPG - 1) / NBPG : 0;
+	if (priority < 1 || priority > MAXPRIO || npages > VSTK_MAXPG ||
+	    (vstk && nargs > NBPG / sizeof(long) - 16) ||
+	    (pid=newpid()) == SYSERR) {
 		restore(ps);
 		return(SYSERR);
 	}
 
+    // Get a frame for the page directory
+    get_frm(&frameid);
+
+    // Set up the page directory in the process table
+    proctab[pid].pdbr = (frameid + FRAME0) * NBPG;
+    frm_tab[frameid] = (fr_map_t){
+        .fr_status = FRM_MAPPED,
+        .fr_pid = pid,
+        .fr_vpno = -1,
+        .fr_type = FR_DIR,
+        .fr_next = -1,
+        .fr_prev = -1,
+        .fr_rmap = -1
+    };
+    proctab[pid].pfrhead = -1;
+    frm_link(pid, frameid);
+
+    pgdir_entry = (pd_t *)proctab[pid].pdbr;
+    bzero(pgdir_entry, NBPG);
+
+    for (i = 0; i < 4; i++) {
+        // The first 4 entries map the global page tables
+        pgdir_entry[i].pd_pres = 1;
+        pgdir_entry[i].pd_base = FRAME0 + i;
+    }
+
+	for (i = 0; i < 1024; i++){
+		// Set write permission for all entries
+		pgdir_entry[i].pd_write = 1;
+	}
+
+	/* a virtual stack is built through its top page's frame */
+	if (vstk) {
+		pglock(PGL_FRM);
+		frameid = vstk_map(pid, VSTK_TOPPG - 1);
+		pgunlock(PGL_FRM);
+		if (frameid == SYSERR) {
+			release_frms(pid, -1);
+			restore(ps);
+			return(SYSERR);
+		}
+		saddr = (unsigned long *)((FRAME0 + frameid + 1) * NBPG) - 1;
+		sdelta = VSTK_SP - (unsigned long)saddr;
+		ssize = npages * NBPG;
+	} else {
+		saddr = (unsigned long *)getstk(ssize);
+		if (saddr == (unsigned long *)SYSERR) {
+			release_frms(pid, -1);
+			restore(ps);
+			return(SYSERR);
+		}
+		sdelta = 0;
+	}
+
 	numproc++;
 	pptr = &proctab[pid];
 
@@ -61,8 +132,9 @@ SYSCALL create(procaddr,ssize,priority,name,nargs,args)
 	pptr->pstate = PRSUSP;
 	for (i=0 ; i<PNMLEN && (int)(pptr->pname[i]=name[i])!=0 ; i++)
 		;
-	pptr->pprio = priority;
-	pptr->pbase = (long) saddr;
+	pptr->pprio = pptr->pbprio = priority;
+	pptr->pmutex = -1;
+	pptr->pbase = (long) saddr + sdelta;
 	pptr->pstklen = ssize;
 	pptr->psem = 0;
 	pptr->phasmsg = FALSE;
@@ -70,21 +142,32 @@ SYSCALL create(procaddr,ssize,priority,name,nargs,args)
 	pptr->pirmask[0] = 0;
 	pptr->pnxtkin = BADPID;
 	pptr->pdevs[0] = pptr->pdevs[1] = pptr->ppagedev = BADDEV;
+	pptr->pmajflt = pptr->pminflt = pptr->pevict = 0;
+	pptr->pwback = pptr->pprefhit = 0;
+	pptr->plocked = 0;
+	pptr->vheap = NULL;
+	pptr->pvstk = npages;
+	pptr->ppi = 0;			/* joins at the current pass	*/
+	pptr->prate = STRIDE1 / priority;
+	pptr->plevel = pptr->pqleft = 0;
+	pptr->pperiod = pptr->pbudget = pptr->pleft = pptr->putil = 0;
+	pptr->pdeadline = pptr->pmisses = 0;
+	pptr->pdone = FALSE;
 
 		/* Bottom of stack */
 	*saddr = MAGIC;
-	savsp = (unsigned long)saddr;
+	savsp = (unsigned long)saddr + sdelta;
 
 	/* push arguments */
 	pptr->pargs = nargs;
-	a = (unsigned long *)(&args) + (nargs-1); /* last argument	*/
+	a = argv + (nargs-1);		/* last argument		*/
 	for ( ; nargs > 0 ; nargs--)	/* machine dependent; copy args	*/
 		*--saddr = *a--;	/* onto created process' stack	*/
 	*--saddr = (long)INITRET;	/* push on return address	*/
 
 	*--saddr = pptr->paddr = (long)procaddr; /* where we "ret" to	*/
 	*--saddr = savsp;		/* fake frame ptr for procaddr	*/
-	savsp = (unsigned long) saddr;
+	savsp = (unsigned long) saddr + sdelta;
 
 /* this must match what ctxsw expects: flags, regs, old SP */
 /* emulate 386 "pushal" instruction */
@@ -98,27 +181,7 @@ SYSCALL create(procaddr,ssize,priority,name,nargs,args)
 	*--saddr = savsp;	/* %ebp */
 	*--saddr = 0;		/* %esi */
 	*--saddr = 0;		/* %edi */
-	*pushsp = pptr->pesp = (unsigned long)saddr;
-
-    // Get a frame for the page directory
-    get_frm(&frameid);
-
-    // Set up the page directory in the process table
-    proctab[pid].pdbr = (frameid + FRAME0) * NBPG;
-    frm_tab[frameid] = (fr_map_t){FRM_MAPPED, FR_DIR, pid, -1};
-
-    pgdir_entry = proctab[pid].pdbr;
-
-    for (i = 0; i < 5; i++) {
-        // If within the first 4 entries, set present bit and base
-        pgdir_entry[i].pd_pres = 1;
-        pgdir_entry[i].pd_base = FRAME0 + i;
-    }
-
-	for (i = 5; i < 1024; i++){
-		// Set write permission for all entries
-		pgdir_entry[i].pd_write = 1;
-	}
+	*pushsp = pptr->pesp = (unsigned long)saddr + sdelta;
 
 	restore(ps);
 	return(pid);
@@ -0,0 +1,23 @@
+/* div64.c - div64 */
+
+#include <conf.h>
+#include <kernel.h>
+
+/*------------------------------------------------------------------------
+ * div64 - divide a 64-bit n by d without the compiler's runtime; a
+ *	   quotient past 32 bits gives 0xffffffff, a zero d gives 0
+ *------------------------------------------------------------------------
+ */
+unsigned long div64(unsigned long long n, unsigned long d)
+{
+	unsigned long	hi, q, r;
+
+	hi = (unsigned long) (n >> 32);
+	if (d == 0)
+		return(0);
+	if (hi >= d)
+		return(0xffffffff);
+	asm("divl %4" : "=a" (q), "=d" (r)
+	    : "a" ((unsigned long) n), "d" (hi), "rm" (d));
+	return(q);
+}
@@ -0,0 +1,225 @@
+/* edf.c - setedf, edfwait, edfmisses, edf_print, edfinit, edfdrop,
+ *	   edfcharge, edfadvance, edfrelease */
+
+#include <conf.h>
+#include <kernel.h>
+#include <proc.h>
+#include <q.h>
+#include <sleep.h>
+#include <edf.h>
+#include <stdio.h>
+
+/*
+ * A process given a period and a budget by setedf() is scheduled
+ * earliest deadline first, ahead of every process of the scheduling
+ * class.  Each period it may run budget ms; its deadline is the end of
+ * the period.  A process calls edfwait() when its work for the period
+ * is done and sleeps until the next one starts.  One that uses up its
+ * budget first is held (PRPERIOD) until then; the budget is counted
+ * down by the clock through preempt.  A period that ends before the
+ * process called edfwait() is a deadline miss.  setedf() admits a
+ * process only if the budget/period sum stays within EDF_MAXUTIL,
+ * which leaves the rest of the CPU to the other processes.
+ */
+
+int	edfhead, edftail;
+unsigned long	edfnext = EDF_NONE;
+LOCAL	int	edfutil;		/* admitted, per mille		*/
+LOCAL	unsigned long	edfthrottles;	/* budgets used up		*/
+LOCAL	unsigned long	edfmissed;	/* misses, all processes	*/
+
+/*------------------------------------------------------------------------
+ *  setedf  --  make pid an EDF process running budget ms every period
+ *		ms, starting now, or a normal one again with period 0
+ *------------------------------------------------------------------------
+ */
+SYSCALL	setedf(int pid, int period, int budget)
+{
+	STATWORD ps;
+	struct	pentry	*pptr;
+	int	util, wasready;
+
+	disable(ps);
+	if (isbadpid(pid) || (pptr = &proctab[pid])->pstate == PRFREE ||
+	    period < 0 || budget < 0 || budget > period ||
+	    (period > 0 && budget == 0)) {
+		restore(ps);
+		return(SYSERR);
+	}
+	util = period > 0 ? (budget * 1000 + period - 1) / period : 0;
+	if (edfutil - pptr->putil + util > EDF_MAXUTIL) {
+		restore(ps);
+		return(SYSERR);		/* would not be schedulable	*/
+	}
+	clksync();			/* ctr1000 may be behind	*/
+	if ((wasready = (pptr->pstate == PRREADY)))
+		schremove(pid);
+	else if (pptr->pstate == PRPERIOD) {
+		pptr->pstate = PRREADY;
+		wasready = TRUE;
+	}
+	edfutil += util - pptr->putil;
+	pptr->putil = util;
+	pptr->pperiod = period;
+	pptr->pbudget = pptr->pleft = budget;
+	pptr->pdone = FALSE;
+	pptr->pdeadline = ctr1000 + period;
+	if (period > 0 && pptr->pdeadline < edfnext)
+		edfnext = pptr->pdeadline;
+	if (wasready)
+		schinsert(pid);
+	if (pid == currpid)
+		preempt = schquantum(pptr);
+	resched();
+	restore(ps);
+	return(OK);
+}
+
+/*------------------------------------------------------------------------
+ *  edfwait  --  end the current period's work and wait for the next
+ *------------------------------------------------------------------------
+ */
+SYSCALL	edfwait(void)
+{
+	STATWORD ps;
+	struct	pentry	*pptr;
+
+	disable(ps);
+	if (!isedf(pptr = &proctab[currpid])) {
+		restore(ps);
+		return(SYSERR);
+	}
+	pptr->pdone = TRUE;
+	pptr->pstate = PRPERIOD;
+	resched();
+	restore(ps);
+	return(OK);
+}
+
+/*------------------------------------------------------------------------
+ *  edfmisses  --  return the deadlines pid has missed
+ *------------------------------------------------------------------------
+ */
+SYSCALL	edfmisses(int pid)
+{
+	if (isbadpid(pid) || proctab[pid].pstate == PRFREE)
+		return(SYSERR);
+	return((int) proctab[pid].pmisses);
+}
+
+/*------------------------------------------------------------------------
+ *  edf_print  --  print the EDF processes and the totals
+ *------------------------------------------------------------------------
+ */
+void	edf_print(void)
+{
+	struct	pentry	*pptr;
+	int	pid;
+
+	for (pid = 1; pid < NPROC; pid++) {
+		pptr = &proctab[pid];
+		if (pptr->pstate == PRFREE || !isedf(pptr))
+			continue;
+		kprintf("edf pid %d %-11s period %d budget %d deadline %lu "
+			"misses %lu\n", pid, pptr->pname, pptr->pperiod,
+			pptr->pbudget, pptr->pdeadline, pptr->pmisses);
+	}
+	kprintf("edf util %d/1000 throttles %lu misses %lu\n", edfutil,
+		edfthrottles, edfmissed);
+}
+
+/*------------------------------------------------------------------------
+ *  edfinit  --  make the EDF ready list
+ *------------------------------------------------------------------------
+ */
+void	edfinit(void)
+{
+	edftail = 1 + (edfhead = newqueue());
+	edfnext = EDF_NONE;
+}
+
+/*------------------------------------------------------------------------
+ *  edfdrop  --  give back the CPU share of a dying process
+ *------------------------------------------------------------------------
+ */
+void	edfdrop(int pid)
+{
+	edfutil -= proctab[pid].putil;
+	proctab[pid].putil = 0;
+}
+
+/*------------------------------------------------------------------------
+ *  edfcharge  --  note the budget left by an EDF process leaving the
+ *		   CPU, and hold it until its next period if none is
+ *------------------------------------------------------------------------
+ */
+void	edfcharge(struct pentry *pptr)
+{
+	pptr->pleft = preempt > 0 ? preempt : 0;
+	if (pptr->pleft == 0 && pptr->pstate == PRCURR) {
+		pptr->pstate = PRPERIOD;
+		edfthrottles++;
+	}
+}
+
+/*------------------------------------------------------------------------
+ *  edfadvance  --  start the next period of every EDF process whose
+ *		    deadline has come, without rescheduling; TRUE if any
+ *------------------------------------------------------------------------
+ */
+int	edfadvance(void)
+{
+	struct	pentry	*pptr;
+	unsigned long	next;
+	int	pid, resch;
+
+	next = EDF_NONE;
+	resch = FALSE;
+	for (pid = 1; pid < NPROC; pid++) {
+		pptr = &proctab[pid];
+		if (pptr->pstate == PRFREE || !isedf(pptr))
+			continue;
+		if (pptr->pdeadline <= ctr1000) {
+			if (!pptr->pdone) {
+				pptr->pmisses++;
+				edfmissed++;
+			}
+			pptr->pdeadline += pptr->pperiod;
+			if (pptr->pdeadline <= ctr1000)	/* far behind	*/
+				pptr->pdeadline = ctr1000 + pptr->pperiod;
+			pptr->pleft = pptr->pbudget;
+			pptr->pdone = FALSE;
+			switch (pptr->pstate) {
+
+			case PRPERIOD:
+				pptr->pstate = PRREADY;
+				schinsert(pid);
+				break;
+
+			case PRREADY:		/* the deadline moved	*/
+				schinsert(schremove(pid));
+				break;
+
+			case PRCURR:
+				preempt = pptr->pleft;
+				break;
+			}
+			resch = TRUE;
+		}
+		if (pptr->pdeadline < next)
+			next = pptr->pdeadline;
+	}
+	edfnext = next;
+	return(resch);
+}
+
+/*------------------------------------------------------------------------
+ *  edfrelease  --  called by the clock at edfnext
+ *------------------------------------------------------------------------
+ */
+INTPROC	edfrelease(void)
+{
+	if (edfadvance())
+		resched();
+	return(OK);
+}
@@ -1,4 +1,4 @@
-/* evec.c -- initevec, doevec */
+/* evec.c -- initevec, set_evec, set_tvec, doevec */
 
 #include <conf.h>
 #include <i386.h>    
@@ -70,6 +70,25 @@ int set_evec(unsigned int xnum, u_long handler)
         return(OK);
 }
 
+/*------------------------------------------------------------------------
+ * set_tvec - make exception vector xnum a task gate to TSS selector tss
+ *------------------------------------------------------------------------
+ */
+int set_tvec(unsigned int xnum, unsigned short tss)
+{
+	struct	idt	*pidt;
+
+	pidt = &idt[xnum];
+	pidt->igd_loffset = 0;
+	pidt->igd_segsel = tss;
+	pidt->igd_mbz = 0;
+	pidt->igd_type = IGDT_TASK;
+	pidt->igd_dpl = 0;
+	pidt->igd_present = 1;
+	pidt->igd_hoffset = 0;
+	return(OK);
+}
+
 char *inames[17] = {
 	"divided by zero",
 	"debug exception",
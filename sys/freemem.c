@@ -6,41 +6,19 @@
 #include <stdio.h>
 
 /*------------------------------------------------------------------------
- *  freemem  --  free a memory block, returning it to memlist
+ *  freemem  --  free a memory block, returning it to the kernel heap
  *------------------------------------------------------------------------
  */
 SYSCALL	freemem(struct mblock *block, unsigned size)
 {
 	STATWORD ps;    
-	struct	mblock	*p, *q;
-	unsigned top;
+	int	ret;
 
 	if (size==0 || (unsigned)block>(unsigned)maxaddr
 	    || ((unsigned)block)<((unsigned) &end))
 		return(SYSERR);
-	size = (unsigned)roundmb(size);
 	disable(ps);
-	for( p=memlist.mnext,q= &memlist;
-	     p != (struct mblock *) NULL && p < block ;
-	     q=p,p=p->mnext )
-		;
-	if (((top=q->mlen+(unsigned)q)>(unsigned)block && q!= &memlist) ||
-	    (p!=NULL && (size+(unsigned)block) > (unsigned)p )) {
-		restore(ps);
-		return(SYSERR);
-	}
-	if ( q!= &memlist && top == (unsigned)block )
-			q->mlen += size;
-	else {
-		block->mlen = size;
-		block->mnext = p;
-		q->mnext = block;
-		q = block;
-	}
-	if ( (unsigned)( q->mlen + (unsigned)q ) == (unsigned)p) {
-		q->mlen += p->mlen;
-		q->mnext = p->mnext;
-	}
+	ret = tlsf_free((char *)block, size);
 	restore(ps);
-	return(OK);
+	return(ret);
 }
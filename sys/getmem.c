@@ -1,8 +1,9 @@
-/* getmem.c - getmem */
+/* getmem.c - getmem, memreclaim */
 
 #include <conf.h>
 #include <kernel.h>
 #include <mem.h>
+#include <slab.h>
 #include <stdio.h>
 
 /*------------------------------------------------------------------------
@@ -12,29 +13,26 @@
 WORD *getmem(unsigned nbytes)
 {
 	STATWORD ps;    
-	struct	mblock	*p, *q, *leftover;
+	char	*p;
 
 	disable(ps);
-	if (nbytes==0 || memlist.mnext== (struct mblock *) NULL) {
+	p = tlsf_alloc(nbytes);
+	if (p == NULL && nbytes != 0 && memreclaim() > 0)
+		p = tlsf_alloc(nbytes);		/* the caches gave some back */
+	if (p == NULL) {
 		restore(ps);
 		return( (WORD *)SYSERR);
 	}
-	nbytes = (unsigned int) roundmb(nbytes);
-	for (q= &memlist,p=memlist.mnext ;
-	     p != (struct mblock *) NULL ;
-	     q=p,p=p->mnext)
-		if ( p->mlen == nbytes) {
-			q->mnext = p->mnext;
-			restore(ps);
-			return( (WORD *)p );
-		} else if ( p->mlen > nbytes ) {
-			leftover = (struct mblock *)( (unsigned)p + nbytes );
-			q->mnext = leftover;
-			leftover->mnext = p->mnext;
-			leftover->mlen = p->mlen - nbytes;
-			restore(ps);
-			return( (WORD *)p );
-		}
 	restore(ps);
-	return( (WORD *)SYSERR );
+	return( (WORD *)p );
+}
+
+/*------------------------------------------------------------------------
+ * memreclaim  --  give memory held by the kernel's caches (empty slabs,
+ *		   spare stacks) back to the heap; return how many blocks
+ *------------------------------------------------------------------------
+ */
+int memreclaim(void)
+{
+	return(kmem_reap() + stkc_reclaim());
 }
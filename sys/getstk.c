@@ -12,34 +12,24 @@
 WORD *getstk(unsigned int nbytes)
 {
 	STATWORD ps;    
-	struct	mblock	*p, *q;	/* q follows p along memlist		*/
-	struct	mblock	*fits, *fitsq=NULL;
-	WORD	len;
+	WORD	*top;
+	char	*p;
 
 	disable(ps);
 	if (nbytes == 0) {
 		restore(ps);
 		return( (WORD *)SYSERR );
 	}
-	nbytes = (unsigned int) roundew(nbytes);
-	fits = (struct mblock *) NULL;
-	q = &memlist;
-	for (p = q->mnext ; p !=(struct mblock *) NULL ; q = p,p = p->mnext)
-		if ( p->mlen >= nbytes) {
-			fitsq = q;
-			fits = p;
-		}
-	if (fits == (struct mblock *) NULL) {
+	nbytes = (unsigned int) roundmb(nbytes);  /* what freestk gives back */
+	p = stkc_get(nbytes);
+	if (p == NULL && (p = tlsf_alloc(nbytes)) == NULL && memreclaim() > 0)
+		p = tlsf_alloc(nbytes);
+	if (p == NULL) {
 		restore(ps);
 		return( (WORD *)SYSERR );
 	}
-	if (nbytes == (len = fits->mlen) ) {
-		fitsq->mnext = fits->mnext;
-	} else {
-		fits->mlen -= nbytes;
-	}
-	fits = (struct mblock *) ((WORD) fits + len - sizeof(WORD));
-	*((WORD *) fits) = nbytes;
+	top = (WORD *) (p + nbytes - sizeof(WORD));
+	*top = nbytes;
 	restore(ps);
-	return( (WORD *) fits);
+	return(top);
 }
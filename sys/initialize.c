@@ -11,6 +11,8 @@
 #include <q.h>
 #include <io.h>
 #include <paging.h>
+#include <edf.h>
+#include <mutex.h>
 #include <stdbool.h>
 
 /*#define DETAIL */
@@ -33,7 +35,6 @@ int	nextsem;		/* next sempahore slot to use in screate*/
 struct	qent	q[NQENT];	/* q table (see queue.c)		*/
 int	nextqueue;		/* next slot in q structure to use	*/
 char	*maxaddr;		/* max memory address (set by sizmem)	*/
-struct	mblock	memlist;	/* list of free memory blocks		*/
 #ifdef	Ntty
 struct  tty     tty[Ntty];	/* SLU buffers and mode control		*/
 #endif
@@ -43,13 +44,13 @@ int	numproc;		/* number of live user processes	*/
 int	currpid;		/* id of currently running process	*/
 int	reboot = 0;		/* non-zero after first boot		*/
 
-int	rdyhead,rdytail;	/* head/tail of ready list (q indicies)	*/
 char 	vers[80];
 int	console_dev;		/* the console device			*/
 
 /*  added for the demand paging */
 bool debug_option = false;
 int pr_qhead = -1; 
+int pr_qtail = -1;
 int page_replace_policy = SC;
 bs_map_t bsm_tab[8];	/* setting size of bsm_tab to 8 as there are 8 backing stores available */
 fr_map_t frm_tab[NFRAMES]; /* setting size of frames to NFRAMES (1024) available physical memory frames */
@@ -123,7 +124,7 @@ nulluser()				/* babysit CPU when no one is home */
 	resume(userpid);
 
 	while (TRUE)
-		/* empty */;
+		pause();		/* until an interrupt		*/
 }
 
 /*------------------------------------------------------------------------
@@ -137,8 +138,6 @@ sysinit()
 	int	i,j;
 	struct	pentry	*pptr;
 	struct	sentry	*sptr;
-	struct	mblock	*mptr;
-	SYSCALL pfintr();
 
 	pt_t *pgtbl_entry;
 	pd_t *pgdir_entry;
@@ -149,33 +148,24 @@ sysinit()
 	nextsem = NSEM-1;
 	nextqueue = NPROC;		/* q[0..NPROC-1] are processes */
 
-	/* initialize free memory list */
+	/* initialize the kernel heap */
 	/* PC version has to pre-allocate 640K-1024K "hole" */
+	tlsf_init();
 	if (maxaddr+1 > HOLESTART) {
-		memlist.mnext = mptr = (struct mblock *) roundmb(&end);
-		mptr->mnext = (struct mblock *)HOLEEND;
-		mptr->mlen = (int) truncew(((unsigned) HOLESTART -
-	     		 (unsigned)&end));
-        mptr->mlen -= 4;
-
-		mptr = (struct mblock *) HOLEEND;
-		mptr->mnext = 0;
-		mptr->mlen = (int) truncew((unsigned)maxaddr - HOLEEND -
-	      		NULLSTK);
-/*
-		mptr->mlen = (int) truncew((unsigned)maxaddr - (4096 - 1024 ) *  4096 - HOLEEND - NULLSTK);
-*/
-	} else {
-		/* initialize free memory list */
-		memlist.mnext = mptr = (struct mblock *) roundmb(&end);
-		mptr->mnext = 0;
-		mptr->mlen = (int) truncew((unsigned)maxaddr - (int)&end -
+		tlsf_addpool((char *) roundmb(&end), (unsigned) HOLESTART -
+			(unsigned) roundmb(&end) - 4);
+		tlsf_addpool((char *) HOLEEND, (unsigned) maxaddr - HOLEEND -
 			NULLSTK);
+	} else {
+		tlsf_addpool((char *) roundmb(&end), (unsigned) maxaddr -
+			(unsigned) roundmb(&end) - NULLSTK);
 	}
 	
 
-	for (i=0 ; i<NPROC ; i++)	/* initialize process table */
+	for (i=0 ; i<NPROC ; i++) {	/* initialize process table */
 		proctab[i].pstate = PRFREE;
+		proctab[i].pfrhead = -1;
+	}
 
 
 #ifdef	MEMMARK
@@ -208,15 +198,18 @@ sysinit()
 	*( (int *)pptr->pbase ) = MAGIC;
 	pptr->paddr = (WORD) nulluser;
 	pptr->pargs = 0;
-	pptr->pprio = 0;
+	pptr->pprio = pptr->pbprio = 0;
+	pptr->pmutex = -1;
 	currpid = NULLPROC;
 
 	for (i=0 ; i<NSEM ; i++) {	/* initialize semaphores */
 		(sptr = &semaph[i])->sstate = SFREE;
 		sptr->sqtail = 1 + (sptr->sqhead = newqueue());
 	}
+	minit();			/* and mutexes			*/
 
-	rdytail = 1 + (rdyhead=newqueue());/* ready list */
+	rdyinit();			/* ready lists, one per priority */
+	edfinit();			/* and the EDF one		*/
 	
 	backing_store_map(); /* backing store memory table initialized*/
 	frame_table_map(); /* frame map table initialized */
@@ -269,7 +262,7 @@ sysinit()
 		} 	
 	}
 	
-	set_evec(14,(u_long)pfintr); /* ISR for page fault at interrupt number 14  */
+	pfinit(); /* page faults at interrupt number 14 run as their own task */
 	write_cr3(proctab[NULLPROC].pdbr);
 	enable_paging(); /* calling enable paging function  */
 
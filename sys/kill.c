@@ -1,4 +1,4 @@
-/* kill.c - kill */
+/* kill.c - kill, kill_reap */
 
 #include <conf.h>
 #include <kernel.h>
@@ -8,6 +8,9 @@
 #include <io.h>
 #include <q.h>
 #include <stdio.h>
+#include <paging.h>
+#include <edf.h>
+#include <mutex.h>
 
 /*------------------------------------------------------------------------
  * kill  --  kill a process and remove it from the system
@@ -39,15 +42,47 @@ SYSCALL kill(int pid)
 	
 	send(pptr->pnxtkin, pid);
 
-	freestk(pptr->pbase, pptr->pstklen);
+	if (pid == currpid && pptr->pvstk > 0)
+		vstk_exit(pid);		/* kill_reap() on another stack	*/
+	kill_reap(pid);
+	restore(ps);
+
+	return(OK);
+}
+
+/*------------------------------------------------------------------------
+ * kill_reap  --  free what a dying process holds and take it off the
+ *		  queues; interrupts are disabled
+ *------------------------------------------------------------------------
+ */
+int kill_reap(int pid)
+{
+	struct	pentry	*pptr = &proctab[pid];
+	int	woke;
+
+	if (pid == currpid)		/* leave the dying address space */
+		write_cr3(proctab[NULLPROC].pdbr);
+	release_frms(pid, -1);		/* pages, page tables, directory */
+	bsm_release(pid);
+	if (pptr->vheap != NULL) {	/* private heap metadata	*/
+		vheap_free(pptr->vheap);
+		pptr->vheap = NULL;
+	}
+	if (pptr->pvstk == 0)		/* a virtual stack went with the frames */
+		freestk(pptr->pbase, pptr->pstklen);
+	edfdrop(pid);
+	woke = mreap(pid);		/* hand on the mutexes it holds	*/
 	switch (pptr->pstate) {
 
 	case PRCURR:	pptr->pstate = PRFREE;	/* suicide */
 			resched();
 
 	case PRWAIT:	semaph[pptr->psem].semcnt++;
+			dequeue(pid);
+			pptr->pstate = PRFREE;
+			break;
 
-	case PRREADY:	dequeue(pid);
+	case PRREADY:	schremove(pid);
 			pptr->pstate = PRFREE;
 			break;
 
@@ -56,10 +91,7 @@ SYSCALL kill(int pid)
 						/* fall through	*/
 	default:	pptr->pstate = PRFREE;
 	}
-	
-	release_bs(proctab[currpid].store); // deallocating a backing store associated with the current process
-
-	restore(ps);
-
+	if (woke)
+		resched();
 	return(OK);
 }
\ No newline at end of file
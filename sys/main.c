@@ -3,6 +3,9 @@
 #include <proc.h>
 #include <stdio.h>
 #include <paging.h>
+#include <mem.h>
+#include <sleep.h>
+#include <timer.h>
 
 #define PROC1_VADDR 0x40000000
 #define PROC1_VPNO  0x40000
@@ -47,7 +50,7 @@ void proc1_test2(char *msg, int lck) {
   *(x + 1) = 200;
 
   kprintf("heap variable: %d %d\n", *x, *(x + 1));
-  vfreemem(x, 1024);
+  vfreemem((struct mblock *) x, 1024);
 }
 
 void proc1_test3(char *msg, int lck) {
@@ -72,13 +75,34 @@ int main() {
   int pid1;
   int pid2;
 
+#ifdef PGBENCH
+  pgbench();
+  return 0;
+#endif
+#ifdef VMBENCH
+  vmbench();
+  return 0;
+#endif
+#ifdef STKBENCH
+  stkbench();
+  return 0;
+#endif
+#ifdef SLPBENCH
+  slpbench();
+  return 0;
+#endif
+#ifdef TMBENCH
+  tmbench();
+  return 0;
+#endif
+
   kprintf("\n1: shared memory\n");
   pid1 = create(proc1_test1, 2000, 20, "proc1_test1", 0, NULL);
   resume(pid1);
   sleep(10);
 
   kprintf("\n2: vgetmem/vfreemem\n");
-  pid1 = vcreate(proc1_test2, 2000, 100, 20, "proc1_test2", 0, NULL);
+  pid1 = vcreate((int *) proc1_test2, 2000, 100, 20, "proc1_test2", 0, NULL);
   kprintf("pid %d has private heap\n", pid1);
   resume(pid1);
   sleep(3);
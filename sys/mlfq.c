@@ -0,0 +1,206 @@
+/* mlfq.c - mlfqquantum, mlfqboost, getmlfqstat, mlfqstat_print,
+ *	    mlfq_reset, mlfq_charge, mlfq_pick, mlfq_quantum */
+
+#include <conf.h>
+#include <kernel.h>
+#include <proc.h>
+#include <q.h>
+#include <sleep.h>
+#include <mlfq.h>
+#include <edf.h>
+#include <stdio.h>
+
+/*
+ * Under MLFQSCHED a process's level plevel, not its priority, decides
+ * when it runs: level l is ready list priority mlfqprio(l).  A level's
+ * quantum is an allotment: a process preempted by a higher level keeps
+ * what is left of it (pqleft, 0 for a whole quantum) for its next turn,
+ * so giving up the CPU now and then does not keep a CPU-bound process
+ * up.  A process still running when its allotment is used up drops a
+ * level; one that blocks (semaphore, mutex, receive, sleep, tty input)
+ * before then rises a level.  Every mq_boostms all processes go back to
+ * level 0, so the bottom levels cannot starve.  New processes start at
+ * level 0.
+ */
+
+LOCAL	struct	mlfqstat	mq = {
+	{ QUANTUM, 2*QUANTUM, 4*QUANTUM, 8*QUANTUM,
+	  16*QUANTUM, 32*QUANTUM, 64*QUANTUM, 128*QUANTUM },
+	{ 0 }, { 0 }, { 0 }, 0, 0, 0, MLFQ_BOOST
+	};
+LOCAL	unsigned long	mq_lastboost;	/* ctr1000 at the last boost	*/
+
+LOCAL	void	mlfq_boostall(void);
+
+/*------------------------------------------------------------------------
+ *  mlfqquantum  --  set the quantum of a level in clock ticks, returning
+ *		     the old one
+ *------------------------------------------------------------------------
+ */
+SYSCALL	mlfqquantum(int level, int ticks)
+{
+	STATWORD ps;
+	int	old;
+
+	if (level < 0 || level >= NMLFQ || ticks < 1)
+		return(SYSERR);
+	disable(ps);
+	old = mq.mq_quantum[level];
+	mq.mq_quantum[level] = ticks;
+	restore(ps);
+	return(old);
+}
+
+/*------------------------------------------------------------------------
+ *  mlfqboost  --  set the boost period in ms (0: never), returning the
+ *		   old one
+ *------------------------------------------------------------------------
+ */
+SYSCALL	mlfqboost(int ms)
+{
+	STATWORD ps;
+	int	old;
+
+	if (ms < 0)
+		return(SYSERR);
+	disable(ps);
+	old = mq.mq_boostms;
+	mq.mq_boostms = ms;
+	mq_lastboost = ctr1000;
+	restore(ps);
+	return(old);
+}
+
+/*------------------------------------------------------------------------
+ *  getmlfqstat  --  copy out the level settings and residency counts
+ *------------------------------------------------------------------------
+ */
+SYSCALL	getmlfqstat(struct mlfqstat *st)
+{
+	STATWORD ps;
+	int	pid, l;
+
+	if (st == NULL)
+		return(SYSERR);
+	disable(ps);
+	for (l = 0; l < NMLFQ; l++)
+		mq.mq_nproc[l] = 0;
+	for (pid = 1; pid < NPROC; pid++)
+		if (proctab[pid].pstate != PRFREE)
+			mq.mq_nproc[proctab[pid].plevel]++;
+	*st = mq;
+	restore(ps);
+	return(OK);
+}
+
+/*------------------------------------------------------------------------
+ *  mlfqstat_print  --  print one line per level and the totals
+ *------------------------------------------------------------------------
+ */
+void	mlfqstat_print(void)
+{
+	struct	mlfqstat	st;
+	int	l;
+
+	getmlfqstat(&st);
+	for (l = 0; l < NMLFQ; l++)
+		kprintf("mlfq level %d quantum %d procs %d ms %lu picks %lu\n",
+			l, st.mq_quantum[l], st.mq_nproc[l], st.mq_time[l],
+			st.mq_picks[l]);
+	kprintf("mlfq demote %lu promote %lu boosts %lu boostms %d\n",
+		st.mq_demote, st.mq_promote, st.mq_boosts, st.mq_boostms);
+}
+
+/*------------------------------------------------------------------------
+ *  mlfq_reset  --  put every process at level 0, as setschedclass()
+ *		    switches to MLFQSCHED; nothing is ready meanwhile
+ *------------------------------------------------------------------------
+ */
+void	mlfq_reset(void)
+{
+	int	pid;
+
+	for (pid = 0; pid < NPROC; pid++)
+		proctab[pid].plevel = proctab[pid].pqleft = 0;
+	mq_lastboost = ctr1000;
+}
+
+/*------------------------------------------------------------------------
+ *  mlfq_charge  --  account ran ms to the process leaving the CPU and
+ *		     move it down if it used its quantum, up if it blocked
+ *------------------------------------------------------------------------
+ */
+void	mlfq_charge(struct pentry *pptr, unsigned long ran)
+{
+	mq.mq_time[pptr->plevel] += ran;
+	pptr->pqleft = preempt > 0 ? preempt : 0;
+	switch (pptr->pstate) {
+
+	case PRCURR:
+		if (pptr->pqleft == 0 && pptr->plevel < NMLFQ - 1) {
+			pptr->plevel++;
+			mq.mq_demote++;
+		}
+		break;
+
+	case PRWAIT:
+	case PRRECV:
+	case PRTRECV:
+	case PRSLEEP:
+	case PRMUTEX:
+		if (pptr->pqleft > 0 && pptr->plevel > 0) {
+			pptr->plevel--;
+			pptr->pqleft = 0;
+			mq.mq_promote++;
+		}
+		break;
+	}
+}
+
+/*------------------------------------------------------------------------
+ *  mlfq_pick  --  boost everyone if it is due, then remove and return
+ *		   the first process of the highest level
+ *------------------------------------------------------------------------
+ */
+int	mlfq_pick(void)
+{
+	int	pid;
+
+	if (mq.mq_boostms > 0 && ctr1000 - mq_lastboost >= mq.mq_boostms)
+		mlfq_boostall();
+	if ((pid = rdyget()) != NULLPROC && pid != EMPTY)
+		mq.mq_picks[proctab[pid].plevel]++;
+	return(pid);
+}
+
+/*------------------------------------------------------------------------
+ *  mlfq_quantum  --  return the ticks pptr has left at its level
+ *------------------------------------------------------------------------
+ */
+int	mlfq_quantum(struct pentry *pptr)
+{
+	if (pptr->pqleft > 0)
+		return(pptr->pqleft);
+	return(mq.mq_quantum[pptr->plevel]);
+}
+
+/*------------------------------------------------------------------------
+ *  mlfq_boostall  --  move every process to level 0
+ *------------------------------------------------------------------------
+ */
+LOCAL	void	mlfq_boostall(void)
+{
+	struct	pentry	*pptr;
+	int	pid;
+
+	for (pid = 1; pid < NPROC; pid++) {
+		pptr = &proctab[pid];
+		if (pptr->pstate == PRFREE || pptr->plevel == 0)
+			continue;
+		pptr->plevel = pptr->pqleft = 0;
+		if (pptr->pstate == PRREADY && !isedf(pptr))
+			rdyinsert(rdyremove(pid), mlfqprio(0));
+	}
+	mq.mq_boosts++;
+	mq_lastboost = ctr1000;
+}
@@ -0,0 +1,348 @@
+/* mutex.c - mcreate, mdelete, mlock, munlock, getmstat, mstat_print,
+ *	     minit, minherit, mreap, mhandoff, mdeadlock */
+
+#include <conf.h>
+#include <kernel.h>
+#include <proc.h>
+#include <q.h>
+#include <mutex.h>
+#include <timer.h>
+#include <stdio.h>
+
+/*
+ * A mutex has an owner, and only the owner may unlock it.  Taking a
+ * free mutex, or giving back one nobody waits for, just sets mowner
+ * and never calls resched().  A process that finds the mutex held waits
+ * on its queue (PRMUTEX), which is kept in priority order, and lends
+ * its priority to the owner: each process runs at pprio, the highest
+ * of its own priority pbprio and those of the first waiters of every
+ * mutex it holds.  If the owner is itself waiting for a mutex, it moves
+ * up that queue and the priority passes on to that owner, and so on
+ * down the chain (minherit()).  munlock() hands the mutex straight to
+ * the highest priority waiter, first come first served among equals,
+ * and the old owner drops back to what it has left.  Locking a mutex
+ * that would close a cycle of waiters is refused.
+ *
+ * Priority inheritance works through pprio, which PRIOSCHED, lottery
+ * and stride scheduling all use; MLFQSCHED ranks by level instead, and
+ * EDF processes by deadline, so neither sees it.
+ */
+
+struct	mentry	mutab[NMUTEX];
+LOCAL	int	nextmutex;		/* where mcreate() looks first	*/
+
+LOCAL	void	mhandoff(int);
+LOCAL	int	mdeadlock(int);
+
+/*------------------------------------------------------------------------
+ *  mcreate  --  create an unlocked mutex, returning its id
+ *------------------------------------------------------------------------
+ */
+SYSCALL	mcreate(void)
+{
+	STATWORD ps;
+	struct	mentry	*mptr;
+	int	i, m;
+
+	disable(ps);
+	for (i = 0; i < NMUTEX; i++) {
+		m = nextmutex;
+		if (++nextmutex >= NMUTEX)
+			nextmutex = 0;
+		if ((mptr = &mutab[m])->mstate == MFREE) {
+			mptr->mstate = MUSED;
+			mptr->mowner = NOOWNER;
+			mptr->mlocks = mptr->mwaits = mptr->mboosts = 0;
+			mptr->mwaitus = mptr->mwaitmax = 0;
+			/* mqhead and mqtail were set by minit()	*/
+			restore(ps);
+			return(m);
+		}
+	}
+	restore(ps);
+	return(SYSERR);
+}
+
+/*------------------------------------------------------------------------
+ *  mdelete  --  delete a mutex; its waiters return DELETED
+ *------------------------------------------------------------------------
+ */
+SYSCALL	mdelete(int m)
+{
+	STATWORD ps;
+	struct	mentry	*mptr;
+	int	owner, pid;
+
+	disable(ps);
+	if (isbadmutex(m) || (mptr = &mutab[m])->mstate == MFREE) {
+		restore(ps);
+		return(SYSERR);
+	}
+	mptr->mstate = MFREE;
+	owner = mptr->mowner;
+	mptr->mowner = NOOWNER;
+	if (nonempty(mptr->mqhead)) {
+		while ((pid = getfirst(mptr->mqhead)) != EMPTY) {
+			proctab[pid].pwaitret = DELETED;
+			proctab[pid].pmutex = -1;
+			ready(pid, RESCHNO);
+		}
+		minherit(owner);	/* what it lent is gone		*/
+		resched();
+	}
+	restore(ps);
+	return(OK);
+}
+
+/*------------------------------------------------------------------------
+ *  mlock  --  take mutex m, waiting while another process holds it
+ *------------------------------------------------------------------------
+ */
+SYSCALL	mlock(int m)
+{
+	STATWORD ps;
+	struct	mentry	*mptr;
+	struct	pentry	*pptr;
+
+	disable(ps);
+	if (isbadmutex(m) || (mptr = &mutab[m])->mstate == MFREE) {
+		restore(ps);
+		return(SYSERR);
+	}
+	if (mptr->mowner == NOOWNER) {	/* the fast path		*/
+		mptr->mowner = currpid;
+		mptr->mlocks++;
+		restore(ps);
+		return(OK);
+	}
+	if (mptr->mowner == currpid || mdeadlock(m)) {
+		restore(ps);
+		return(SYSERR);
+	}
+	pptr = &proctab[currpid];
+	pptr->pstate = PRMUTEX;
+	pptr->pmutex = m;
+	pptr->pwaitret = OK;
+	pptr->pmwait = gettime_ns();
+	insert(currpid, mptr->mqhead, pptr->pprio);
+	mptr->mwaits++;
+	if (pptr->pprio > proctab[mptr->mowner].pprio)
+		mptr->mboosts++;
+	minherit(mptr->mowner);
+	resched();
+	restore(ps);
+	return(pptr->pwaitret);
+}
+
+/*------------------------------------------------------------------------
+ *  munlock  --  give back mutex m, which the caller holds
+ *------------------------------------------------------------------------
+ */
+SYSCALL	munlock(int m)
+{
+	STATWORD ps;
+	struct	mentry	*mptr;
+
+	disable(ps);
+	if (isbadmutex(m) || (mptr = &mutab[m])->mstate == MFREE ||
+	    mptr->mowner != currpid) {
+		restore(ps);
+		return(SYSERR);
+	}
+	if (isempty(mptr->mqhead)) {	/* the fast path		*/
+		mptr->mowner = NOOWNER;
+		restore(ps);
+		return(OK);
+	}
+	mhandoff(m);
+	minherit(currpid);		/* back to what it has left	*/
+	resched();
+	restore(ps);
+	return(OK);
+}
+
+/*------------------------------------------------------------------------
+ *  getmstat  --  copy mutex m's owner, waiters and statistics into *ms
+ *------------------------------------------------------------------------
+ */
+SYSCALL	getmstat(int m, struct mstat *ms)
+{
+	STATWORD ps;
+	struct	mentry	*mptr;
+	int	next;
+
+	if (ms == NULL)
+		return(SYSERR);
+	disable(ps);
+	if (isbadmutex(m) || (mptr = &mutab[m])->mstate == MFREE) {
+		restore(ps);
+		return(SYSERR);
+	}
+	ms->ms_owner = mptr->mowner;
+	ms->ms_nwait = 0;
+	for (next = q[mptr->mqhead].qnext; next < NPROC; next = q[next].qnext)
+		ms->ms_nwait++;
+	ms->ms_locks = mptr->mlocks;
+	ms->ms_waits = mptr->mwaits;
+	ms->ms_boosts = mptr->mboosts;
+	ms->ms_waitus = mptr->mwaitus;
+	ms->ms_waitmax = mptr->mwaitmax;
+	restore(ps);
+	return(OK);
+}
+
+/*------------------------------------------------------------------------
+ *  mstat_print  --  print the statistics of every mutex in use
+ *------------------------------------------------------------------------
+ */
+void	mstat_print(void)
+{
+	struct	mstat	ms;
+	int	m;
+
+	for (m = 0; m < NMUTEX; m++) {
+		if (getmstat(m, &ms) == SYSERR)
+			continue;
+		kprintf("mutex %d owner %d waiting %d locks %lu waited %lu "
+			"boosts %lu wait_us %lu max_us %lu\n", m, ms.ms_owner,
+			ms.ms_nwait, ms.ms_locks, ms.ms_waits, ms.ms_boosts,
+			ms.ms_waitus, ms.ms_waitmax);
+	}
+}
+
+/*------------------------------------------------------------------------
+ *  minit  --  free every mutex and make its queue
+ *------------------------------------------------------------------------
+ */
+void	minit(void)
+{
+	struct	mentry	*mptr;
+	int	m;
+
+	for (m = 0; m < NMUTEX; m++) {
+		(mptr = &mutab[m])->mstate = MFREE;
+		mptr->mowner = NOOWNER;
+		mptr->mqtail = 1 + (mptr->mqhead = newqueue());
+	}
+	nextmutex = 0;
+}
+
+/*------------------------------------------------------------------------
+ *  minherit  --  set pid's pprio from its own priority and the waiters
+ *		  of the mutexes it holds, passing a change on down the
+ *		  chain of owners; interrupts are disabled
+ *------------------------------------------------------------------------
+ */
+void	minherit(int pid)
+{
+	struct	pentry	*pptr;
+	struct	mentry	*mptr;
+	int	prio, m, n;
+
+	for (n = 0; n < NPROC && !isbadpid(pid); n++) {
+		pptr = &proctab[pid];
+		prio = pptr->pbprio;
+		for (m = 0; m < NMUTEX; m++) {
+			mptr = &mutab[m];
+			if (mptr->mstate == MUSED && mptr->mowner == pid &&
+			    nonempty(mptr->mqhead) &&
+			    lastkey(mptr->mqtail) > prio)
+				prio = lastkey(mptr->mqtail);
+		}
+		if (prio == pptr->pprio)
+			return;
+		pptr->pprio = prio;
+		switch (pptr->pstate) {
+
+		case PRREADY:
+			schinsert(schremove(pid));
+			return;
+
+		case PRMUTEX:		/* its place in line moves too	*/
+			mptr = &mutab[pptr->pmutex];
+			dequeue(pid);
+			insert(pid, mptr->mqhead, prio);
+			pid = mptr->mowner;
+			break;
+
+		default:
+			return;
+		}
+	}
+}
+
+/*------------------------------------------------------------------------
+ *  mreap  --  take dying pid off the mutex it waits for and hand on the
+ *	       ones it holds; TRUE if that made a process ready
+ *------------------------------------------------------------------------
+ */
+int	mreap(int pid)
+{
+	struct	pentry	*pptr = &proctab[pid];
+	int	m, woke;
+
+	if (pptr->pstate == PRMUTEX) {
+		dequeue(pid);
+		m = pptr->pmutex;
+		pptr->pmutex = -1;
+		minherit(mutab[m].mowner);
+	}
+	woke = FALSE;
+	for (m = 0; m < NMUTEX; m++) {
+		if (mutab[m].mstate != MUSED || mutab[m].mowner != pid)
+			continue;
+		if (isempty(mutab[m].mqhead))
+			mutab[m].mowner = NOOWNER;
+		else {
+			mhandoff(m);
+			woke = TRUE;
+		}
+	}
+	return(woke);
+}
+
+/*------------------------------------------------------------------------
+ *  mhandoff  --  make the first waiter of mutex m its owner, and ready
+ *------------------------------------------------------------------------
+ */
+LOCAL	void	mhandoff(int m)
+{
+	struct	mentry	*mptr = &mutab[m];
+	struct	pentry	*pptr;
+	unsigned long long ns;
+	unsigned long	us;
+	int	pid;
+
+	pid = getlast(mptr->mqtail);	/* highest priority, longest	*/
+	pptr = &proctab[pid];		/*  waiting among equals	*/
+	ns = gettime_ns() - pptr->pmwait;
+	us = ns >> 32 ? 0xffffffffUL / 1000 : (unsigned long) ns / 1000;
+	mptr->mwaitus += us;
+	if (us > mptr->mwaitmax)
+		mptr->mwaitmax = us;
+	mptr->mowner = pid;
+	mptr->mlocks++;
+	pptr->pmutex = -1;
+	ready(pid, RESCHNO);
+	minherit(pid);			/* the rest now lend it theirs	*/
+}
+
+/*------------------------------------------------------------------------
+ *  mdeadlock  --  TRUE if the caller waiting for mutex m would close a
+ *		   cycle of processes waiting for each other
+ *------------------------------------------------------------------------
+ */
+LOCAL	int	mdeadlock(int m)
+{
+	int	pid, n;
+
+	pid = mutab[m].mowner;
+	for (n = 0; n < NPROC && pid != NOOWNER; n++) {
+		if (pid == currpid)
+			return(TRUE);
+		if (proctab[pid].pstate != PRMUTEX)
+			return(FALSE);
+		pid = mutab[proctab[pid].pmutex].mowner;
+	}
+	return(FALSE);
+}
@@ -0,0 +1,133 @@
+/* readyq.c - rdyinit, rdyinsert, rdyremove, rdyget, rdymax, rdydraw */
+
+#include <conf.h>
+#include <kernel.h>
+#include <q.h>
+
+/*
+ * The ready list is one FIFO list in q[] per priority, plus a bitmap of
+ * the priorities whose lists are nonempty: bit p%32 of rdymap[p/32],
+ * and bit i of rdysum when rdymap[i] is nonzero.  The highest ready
+ * priority is two bsr instructions away, so making a process ready,
+ * taking it off and picking the next one cost the same however many
+ * processes are ready.  A process's qkey holds the priority whose list
+ * it is on.  The lists also count their processes, so the lottery can
+ * treat each priority as that many tickets per process.
+ */
+
+int	rdyhead;			/* head of priority 0's list	*/
+unsigned long	rdytickets;		/* sum of ready priorities	*/
+LOCAL	unsigned long	rdymap[NRDYPRIO / 32];
+LOCAL	unsigned long	rdysum;
+LOCAL	int	rdycount[NRDYPRIO];	/* processes on each list	*/
+
+#define	bsr(w, bit)	asm("bsrl %1, %0" : "=r" (bit) : "rm" (w))
+
+/*------------------------------------------------------------------------
+ * rdyinit  --  make the per-priority ready lists, all empty
+ *------------------------------------------------------------------------
+ */
+void rdyinit(void)
+{
+	int	prio;
+
+	rdyhead = newqueue();
+	for (prio = 1; prio < NRDYPRIO; prio++)
+		newqueue();		/* consecutive head/tail pairs	*/
+	for (prio = 0; prio < NRDYPRIO; prio++)
+		rdycount[prio] = 0;
+	for (prio = 0; prio < NRDYPRIO / 32; prio++)
+		rdymap[prio] = 0;
+	rdysum = rdytickets = 0;
+}
+
+/*------------------------------------------------------------------------
+ * rdyinsert  --  put pid at the tail of the ready list of priority prio
+ *------------------------------------------------------------------------
+ */
+int rdyinsert(int pid, int prio)
+{
+	enqueue(pid, rdyq(prio) + 1);
+	q[pid].qkey = prio;
+	rdycount[prio]++;
+	rdytickets += prio;
+	rdymap[prio >> 5] |= 1UL << (prio & 31);
+	rdysum |= 1UL << (prio >> 5);
+	return(OK);
+}
+
+/*------------------------------------------------------------------------
+ * rdyremove  --  take ready process pid off its list and return it
+ *------------------------------------------------------------------------
+ */
+int rdyremove(int pid)
+{
+	int	prio;
+
+	prio = q[pid].qkey;
+	dequeue(pid);
+	rdycount[prio]--;
+	rdytickets -= prio;
+	if (isempty(rdyq(prio)) &&
+	    (rdymap[prio >> 5] &= ~(1UL << (prio & 31))) == 0)
+		rdysum &= ~(1UL << (prio >> 5));
+	return(pid);
+}
+
+/*------------------------------------------------------------------------
+ * rdyget  --  remove and return the first process of the highest
+ *	       priority, or EMPTY
+ *------------------------------------------------------------------------
+ */
+int rdyget(void)
+{
+	int	prio;
+
+	if ((prio = rdymax()) == EMPTY)
+		return(EMPTY);
+	return(rdyremove(firstid(rdyq(prio))));
+}
+
+/*------------------------------------------------------------------------
+ * rdymax  --  return the highest priority with a ready process, or EMPTY
+ *------------------------------------------------------------------------
+ */
+int rdymax(void)
+{
+	unsigned long	i, bit;
+
+	if (rdysum == 0)
+		return(EMPTY);
+	bsr(rdysum, i);
+	bsr(rdymap[i], bit);
+	return((int) (i << 5 | bit));
+}
+
+/*------------------------------------------------------------------------
+ * rdydraw  --  remove and return the process holding lottery ticket
+ *		ticket, counting from the highest priority down; there
+ *		must be more than ticket tickets
+ *------------------------------------------------------------------------
+ */
+int rdydraw(unsigned long ticket)
+{
+	unsigned long	i, bit, word, sum, held;
+	int	prio, pid;
+
+	for (sum = rdysum; sum != 0; sum &= ~(1UL << i)) {
+		bsr(sum, i);
+		for (word = rdymap[i]; word != 0; word &= ~(1UL << bit)) {
+			bsr(word, bit);
+			prio = (int) (i << 5 | bit);
+			held = (unsigned long) prio * rdycount[prio];
+			if (ticket < held) {
+				pid = firstid(rdyq(prio));
+				for ( ; ticket >= prio; ticket -= prio)
+					pid = q[pid].qnext;
+				return(rdyremove(pid));
+			}
+			ticket -= held;
+		}
+	}
+	return(EMPTY);
+}
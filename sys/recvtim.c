@@ -22,9 +22,7 @@ SYSCALL	recvtim(int maxwait)
 	disable(ps);
 	pptr = &proctab[currpid];
 	if ( !pptr->phasmsg ) {		/* if no message, wait		*/
-	        insertd(currpid, clockq, maxwait*1000);
-		slnempty = TRUE;
-		sltop = (int *)&q[q[clockq].qnext].qkey;
+	        twinsert(currpid, maxwait*1000);
 	        pptr->pstate = PRTRECV;
 		resched();
 	}
@@ -4,11 +4,15 @@
 #include <kernel.h>
 #include <proc.h>
 #include <q.h>
+#include <paging.h>
+#include <sleep.h>
 
 unsigned long currSP;	/* REAL sp of current process */
+unsigned long ctxpdbr;	/* page directory ctxsw switches to */
 
 /*------------------------------------------------------------------------
- * resched  --  reschedule processor to highest priority ready process
+ * resched  --  reschedule processor to the ready process the scheduling
+ *		class picks (by default, the highest priority one)
  *
  * Notes:	Upon entry, currpid gives current process id.
  *		Proctab[currpid].pstate gives correct NEXT state for
@@ -23,10 +27,27 @@ int	resched()
 	register int i;
 
 	disable(PS);
+	if (pfbusy || pgnopreempt > 0) {	/* the pager can't switch	*/
+		pgresched = TRUE;		/*  now (see pglock.c)		*/
+#ifdef	RTCLOCK
+		clkarm();		/* a tick to switch on		*/
+#endif
+		restore(PS);
+		return(OK);
+	}
+	pgresched = FALSE;
+#ifdef	RTCLOCK
+	clksync();			/* time a one-shot has covered	*/
+#endif
 	/* no switch needed if current process priority higher than next*/
 
 	if ( ( (optr= &proctab[currpid])->pstate == PRCURR) &&
-	   (lastkey(rdytail)<optr->pprio)) {
+	   schkeep(optr)) {
+#ifdef	RTCLOCK
+		if (preempt <= 0)	/* it keeps the CPU a quantum	*/
+			preempt = schquantum(optr);
+		clkarm();
+#endif
 		restore(PS);
 		return(OK);
 	}
@@ -45,14 +66,15 @@ int	resched()
 
 	/* force context switch */
 
+	schcharge(optr);
 	if (optr->pstate == PRCURR) {
 		optr->pstate = PRREADY;
-		insert(currpid,rdyhead,optr->pprio);
+		schinsert(currpid);
 	}
 
-	/* remove highest priority process at end of ready list */
+	/* remove the process the scheduling class picks */
 
-	nptr = &proctab[ (currpid = getlast(rdytail)) ];
+	nptr = &proctab[ (currpid = schpick()) ];
 	nptr->pstate = PRCURR;		/* mark it currently running	*/
 #ifdef notdef
 #ifdef	STKCHK
@@ -77,12 +99,14 @@ int	resched()
 #endif	/* STKCHK */
 #endif	/* notdef */
 #ifdef	RTCLOCK
-	preempt = QUANTUM;		/* reset preemption counter	*/
+	preempt = schquantum(nptr);	/* reset preemption counter	*/
+	clkarm();			/* one-shot if it runs alone	*/
 #endif
 #ifdef	DEBUG
 	PrintSaved(nptr);
 #endif
 	
+	ctxpdbr = nptr->pdbr;		/* ctxsw switches address spaces */
 	ctxsw(&optr->pesp, optr->pirmask, &nptr->pesp, nptr->pirmask);
 
 #ifdef	DEBUG
@@ -0,0 +1,311 @@
+/* sched.c - setschedclass, getschedclass, schinsert, schremove, schpick,
+ *	     schkeep, schcharge, schquantum, schalone */
+
+#include <conf.h>
+#include <kernel.h>
+#include <proc.h>
+#include <q.h>
+#include <sleep.h>
+#include <paging.h>
+#include <mlfq.h>
+#include <edf.h>
+#include <stdio.h>
+
+/*
+ * The scheduling class decides which ready process runs next; every
+ * class sees the same calls from ready(), resched() and the rest.
+ *
+ * PRIOSCHED		strict priority, round-robin within a priority.
+ * RANDOMSCHED		lottery: each ready process holds pprio tickets
+ *			and a random ticket picks the next process.
+ * PROPORTIONALSHARE	stride scheduling: a process's pass ppi grows by
+ *			its stride prate (STRIDE1 / pprio) for every
+ *			millisecond it runs, and the smallest pass runs
+ *			next, so CPU time follows the priorities.  Ready
+ *			processes are kept in a heap ordered by pass.
+ * MLFQSCHED		multi-level feedback queue, see mlfq.c.
+ *
+ * All but PROPORTIONALSHARE use the per-priority ready lists.  The null
+ * process holds no tickets, no pass and no level; it runs when nothing
+ * else is ready.  EDF processes (see edf.c) sit on their own list and
+ * run ahead of the class whichever class is in use.
+ */
+
+int	schedclass = PRIOSCHED;
+
+LOCAL	int	sch_heap[NPROC];	/* ready pids, least pass first	*/
+LOCAL	int	sch_hidx[NPROC];	/* pid's heap slot, or -1	*/
+LOCAL	int	sch_nheap;
+LOCAL	unsigned long	sch_vtime;	/* pass of the last one picked	*/
+LOCAL	unsigned long	sch_start;	/* ctr1000 when it was picked	*/
+LOCAL	unsigned long	sch_seed = 2463534242UL;
+
+/* passes wrap; the ready ones are always within 2^31 of each other */
+#define	passlt(a, b)	((long) ((a) - (b)) < 0)
+
+LOCAL	void	sch_up(int);
+LOCAL	void	sch_down(int);
+LOCAL	void	sch_place(int, int);
+LOCAL	unsigned long	sch_random(void);
+
+/*------------------------------------------------------------------------
+ * setschedclass  --  switch every ready process to scheduling class cls
+ *------------------------------------------------------------------------
+ */
+SYSCALL setschedclass(int cls)
+{
+	STATWORD ps;
+	int	pid, i;
+
+	if (cls != PRIOSCHED && cls != RANDOMSCHED &&
+	    cls != PROPORTIONALSHARE && cls != MLFQSCHED)
+		return(SYSERR);
+	disable(ps);
+	for (pid = 0; pid < NPROC; pid++)
+		if (proctab[pid].pstate == PRREADY)
+			schremove(pid);
+	if (schedclass != PROPORTIONALSHARE) {
+		for (i = 0; i < NPROC; i++)
+			sch_hidx[i] = -1;
+		sch_nheap = 0;
+	}
+	if (cls == RANDOMSCHED)
+		sch_seed ^= (unsigned long) read_tsc() | 1;
+	if (cls == MLFQSCHED && schedclass != MLFQSCHED)
+		mlfq_reset();
+	schedclass = cls;
+	for (pid = 0; pid < NPROC; pid++)
+		if (proctab[pid].pstate == PRREADY)
+			schinsert(pid);
+	sch_start = ctr1000;
+	resched();
+	restore(ps);
+	return(OK);
+}
+
+/*------------------------------------------------------------------------
+ * getschedclass  --  return the scheduling class in use
+ *------------------------------------------------------------------------
+ */
+SYSCALL getschedclass(void)
+{
+	return(schedclass);
+}
+
+/*------------------------------------------------------------------------
+ * schinsert  --  make process pid, already PRREADY, eligible to run
+ *------------------------------------------------------------------------
+ */
+int schinsert(int pid)
+{
+	struct	pentry	*pptr = &proctab[pid];
+
+	if (isedf(pptr))
+		return(insert(pid, edfhead, (int) pptr->pdeadline));
+	if (schedclass == MLFQSCHED)
+		return(rdyinsert(pid, pid == NULLPROC ? 0 :
+			mlfqprio(pptr->plevel)));
+	if (schedclass != PROPORTIONALSHARE)
+		return(rdyinsert(pid, pptr->pprio));
+	if (pid == NULLPROC)
+		return(OK);
+	pptr->prate = STRIDE1 / pptr->pprio;
+	if (passlt(pptr->ppi, sch_vtime))	/* no credit for waiting */
+		pptr->ppi = sch_vtime;
+	sch_heap[sch_nheap] = pid;
+	sch_hidx[pid] = sch_nheap;
+	sch_up(sch_nheap++);
+	return(OK);
+}
+
+/*------------------------------------------------------------------------
+ * schremove  --  take ready process pid out of consideration
+ *------------------------------------------------------------------------
+ */
+int schremove(int pid)
+{
+	int	i;
+
+	if (isedf(&proctab[pid]))
+		return(dequeue(pid));
+	if (schedclass != PROPORTIONALSHARE)
+		return(rdyremove(pid));
+	if ((i = sch_hidx[pid]) < 0)
+		return(pid);
+	sch_hidx[pid] = -1;
+	if (i != --sch_nheap) {
+		sch_place(sch_heap[sch_nheap], i);
+		sch_up(i);
+		sch_down(i);
+	}
+	return(pid);
+}
+
+/*------------------------------------------------------------------------
+ * schpick  --  remove and return the process to run next
+ *------------------------------------------------------------------------
+ */
+int schpick(void)
+{
+	int	pid;
+
+	sch_start = ctr1000;
+	if (nonempty(edfhead))
+		return(getfirst(edfhead));
+	switch (schedclass) {
+
+	case RANDOMSCHED:
+		if (rdytickets == 0)
+			return(rdyget());	/* only the null process */
+		return(rdydraw(sch_random() % rdytickets));
+
+	case PROPORTIONALSHARE:
+		if (sch_nheap == 0)
+			return(NULLPROC);
+		pid = schremove(sch_heap[0]);
+		sch_vtime = proctab[pid].ppi;
+		return(pid);
+
+	case MLFQSCHED:
+		return(mlfq_pick());
+
+	default:
+		return(rdyget());
+	}
+}
+
+/*------------------------------------------------------------------------
+ * schkeep  --  TRUE if the running process keeps the CPU without the
+ *		class being asked again
+ *------------------------------------------------------------------------
+ */
+int schkeep(struct pentry *pptr)
+{
+	if (isedf(pptr))		/* until the budget or an earlier	*/
+		return(preempt > 0 &&	/*  deadline ends its turn		*/
+			(isempty(edfhead) ||
+			 firstkey(edfhead) >= (int) pptr->pdeadline));
+	if (nonempty(edfhead))
+		return(FALSE);
+	switch (schedclass) {
+
+	case PRIOSCHED:
+		return(rdymax() < pptr->pprio);
+
+	case MLFQSCHED:			/* an expired quantum moves it */
+		return(preempt > 0 && rdymax() < (pptr == &proctab[NULLPROC] ?
+			0 : mlfqprio(pptr->plevel)));
+
+	default:
+		return(FALSE);
+	}
+}
+
+/*------------------------------------------------------------------------
+ * schcharge  --  charge the process leaving the CPU for the time it had
+ *------------------------------------------------------------------------
+ */
+void schcharge(struct pentry *pptr)
+{
+	unsigned long	ran;
+
+	if (isedf(pptr)) {
+		edfcharge(pptr);
+		return;
+	}
+	if (pptr == &proctab[NULLPROC])
+		return;
+	ran = ctr1000 - sch_start;
+	switch (schedclass) {
+
+	case PROPORTIONALSHARE:
+		if (ran == 0)
+			ran = 1;
+		pptr->ppi += ran * (STRIDE1 / pptr->pprio);
+		break;
+
+	case MLFQSCHED:
+		mlfq_charge(pptr, ran);
+		break;
+	}
+}
+
+/*------------------------------------------------------------------------
+ * schquantum  --  return the clock ticks pptr may run before preemption
+ *------------------------------------------------------------------------
+ */
+int schquantum(struct pentry *pptr)
+{
+	if (isedf(pptr))
+		return(pptr->pleft > 0 ? pptr->pleft : 1);
+	if (schedclass == MLFQSCHED)
+		return(mlfq_quantum(pptr));
+	return(QUANTUM);
+}
+
+/*------------------------------------------------------------------------
+ * schalone  --  TRUE if no process but the null process is ready
+ *------------------------------------------------------------------------
+ */
+int schalone(void)
+{
+	if (nonempty(edfhead))
+		return(FALSE);
+	if (schedclass == PROPORTIONALSHARE)
+		return(sch_nheap == 0);
+	return(rdymax() <= 0);		/* the null process is at 0	*/
+}
+
+/*------------------------------------------------------------------------
+ * sch_up, sch_down  --  move heap slot i toward the root or the leaves
+ *			 until the heap is in pass order again
+ *------------------------------------------------------------------------
+ */
+LOCAL void sch_up(int i)
+{
+	int	pid, parent;
+
+	pid = sch_heap[i];
+	for ( ; i > 0; i = parent) {
+		parent = (i - 1) / 2;
+		if (!passlt(proctab[pid].ppi, proctab[sch_heap[parent]].ppi))
+			break;
+		sch_place(sch_heap[parent], i);
+	}
+	sch_place(pid, i);
+}
+
+LOCAL void sch_down(int i)
+{
+	int	pid, child;
+
+	pid = sch_heap[i];
+	for ( ; (child = 2 * i + 1) < sch_nheap; i = child) {
+		if (child + 1 < sch_nheap &&
+		    passlt(proctab[sch_heap[child + 1]].ppi,
+			   proctab[sch_heap[child]].ppi))
+			child++;
+		if (!passlt(proctab[sch_heap[child]].ppi, proctab[pid].ppi))
+			break;
+		sch_place(sch_heap[child], i);
+	}
+	sch_place(pid, i);
+}
+
+LOCAL void sch_place(int pid, int i)
+{
+	sch_heap[i] = pid;
+	sch_hidx[pid] = i;
+}
+
+/*------------------------------------------------------------------------
+ * sch_random  --  next value of a xorshift generator, for the lottery
+ *------------------------------------------------------------------------
+ */
+LOCAL unsigned long sch_random(void)
+{
+	sch_seed ^= sch_seed << 13;
+	sch_seed ^= sch_seed >> 17;
+	sch_seed ^= sch_seed << 5;
+	return(sch_seed);
+}
@@ -0,0 +1,307 @@
+/* slab.c - kmem_cache_create, kmem_cache_destroy, kmem_cache_alloc,
+ *	    kmem_cache_free, kmem_cache_reap, kmem_reap, kmem_print */
+
+#include <conf.h>
+#include <kernel.h>
+#include <mem.h>
+#include <slab.h>
+#include <stdio.h>
+
+struct	kmcache	kmctab[NKMCACHE];
+
+/* where the objects of a slab with nobj of them start */
+#define	KM_HDR		((unsigned) &((struct kmslab *) 0)->sl_free[0])
+#define	km_objoff(n, a)	((KM_HDR + (n) * sizeof(unsigned short) + (a) - 1) \
+				& ~((a) - 1))
+
+LOCAL	struct	kmslab	*km_grow(struct kmcache *);
+LOCAL	void	km_unlink(struct kmslab **, struct kmslab *);
+LOCAL	void	km_link(struct kmslab **, struct kmslab *);
+LOCAL	int	km_release(struct kmcache *);
+
+/*------------------------------------------------------------------------
+ *  kmem_cache_create  --  make a cache of size-byte objects aligned to
+ *			   align (0 for a cache line), each set up by ctor
+ *			   when its slab is made; return the cache id
+ *------------------------------------------------------------------------
+ */
+int	kmem_cache_create(char *name, unsigned size, unsigned align,
+			  void (*ctor)(void *))
+{
+	STATWORD ps;
+	struct	kmcache	*kc;
+	unsigned	slabsize;
+	int	c, nobj;
+
+	if (align == 0)
+		align = KM_LINE;
+	if (size == 0 || (align & (align - 1)) != 0 || align > KM_MINSLAB)
+		return(SYSERR);
+	if (align < sizeof(int))
+		align = sizeof(int);
+	size = (size + align - 1) & ~(align - 1);
+
+	/* the smallest slab that holds KM_MINOBJ objects, or the largest */
+	for (slabsize = KM_MINSLAB; ; slabsize <<= 1) {
+		nobj = (slabsize - KM_HDR) / (size + sizeof(unsigned short));
+		while (nobj > 0 && km_objoff(nobj, align) + nobj * size > slabsize)
+			nobj--;
+		if (nobj >= KM_MINOBJ || slabsize >= KM_MAXSLAB)
+			break;
+	}
+	if (nobj < 1)
+		return(SYSERR);
+
+	disable(ps);
+	for (c = 0; c < NKMCACHE; c++)
+		if (kmctab[c].kc_state == KMC_FREE)
+			break;
+	if (c >= NKMCACHE) {
+		restore(ps);
+		return(SYSERR);
+	}
+	kc = &kmctab[c];
+	bzero(kc, sizeof(struct kmcache));
+	strncpy(kc->kc_name, name, KM_NAMELEN - 1);
+	kc->kc_state = KMC_USED;
+	kc->kc_size = size;
+	kc->kc_align = align;
+	kc->kc_slabsize = slabsize;
+	kc->kc_nobj = nobj;
+	kc->kc_ctor = ctor;
+	restore(ps);
+	return(c);
+}
+
+/*------------------------------------------------------------------------
+ *  kmem_cache_destroy  --  give back the slabs of a cache none of whose
+ *			    objects are in use, and free its entry
+ *------------------------------------------------------------------------
+ */
+int	kmem_cache_destroy(int c)
+{
+	STATWORD ps;
+	struct	kmcache	*kc;
+
+	disable(ps);
+	if (isbadkmc(c) || (kc = &kmctab[c])->kc_state != KMC_USED ||
+	    kc->kc_inuse != 0) {
+		restore(ps);
+		return(SYSERR);
+	}
+	km_release(kc);
+	kc->kc_state = KMC_FREE;
+	restore(ps);
+	return(OK);
+}
+
+/*------------------------------------------------------------------------
+ *  kmem_cache_alloc  --  take an object from a cache
+ *------------------------------------------------------------------------
+ */
+void	*kmem_cache_alloc(int c)
+{
+	STATWORD ps;
+	struct	kmcache	*kc;
+	struct	kmslab	*s;
+	char	*obj;
+
+	disable(ps);
+	if (isbadkmc(c) || (kc = &kmctab[c])->kc_state != KMC_USED) {
+		restore(ps);
+		return((void *) SYSERR);
+	}
+	if ((s = kc->kc_partial) == NULL) {
+		if ((s = kc->kc_empty) != NULL)
+			km_unlink(&kc->kc_empty, s);
+		else if ((s = km_grow(kc)) == NULL) {
+			kc->kc_fails++;
+			restore(ps);
+			return((void *) SYSERR);
+		}
+		km_link(&kc->kc_partial, s);
+	}
+	obj = s->sl_base + s->sl_free[--s->sl_nfree] * kc->kc_size;
+	s->sl_inuse++;
+	if (s->sl_nfree == 0) {
+		km_unlink(&kc->kc_partial, s);
+		km_link(&kc->kc_full, s);
+	}
+	kc->kc_allocs++;
+	if (++kc->kc_inuse > kc->kc_peak)
+		kc->kc_peak = kc->kc_inuse;
+	restore(ps);
+	return((void *) obj);
+}
+
+/*------------------------------------------------------------------------
+ *  kmem_cache_free  --  return an object to its cache.  It should be in
+ *			 the state the constructor left it in.
+ *------------------------------------------------------------------------
+ */
+int	kmem_cache_free(int c, void *obj)
+{
+	STATWORD ps;
+	struct	kmcache	*kc;
+	struct	kmslab	*s;
+	unsigned	off;
+
+	disable(ps);
+	if (isbadkmc(c) || (kc = &kmctab[c])->kc_state != KMC_USED ||
+	    obj == NULL) {
+		restore(ps);
+		return(SYSERR);
+	}
+	s = (struct kmslab *) ((unsigned long) obj &
+		~(unsigned long) (kc->kc_slabsize - 1));
+	off = (char *) obj - s->sl_base;
+	if ((char *) obj < s->sl_base || off % kc->kc_size != 0 ||
+	    off / kc->kc_size >= kc->kc_nobj || s->sl_inuse == 0) {
+		restore(ps);
+		return(SYSERR);
+	}
+	if (s->sl_nfree == 0) {
+		km_unlink(&kc->kc_full, s);
+		km_link(&kc->kc_partial, s);
+	}
+	s->sl_free[s->sl_nfree++] = off / kc->kc_size;
+	if (--s->sl_inuse == 0) {	/* kept, constructed, until reaped */
+		km_unlink(&kc->kc_partial, s);
+		km_link(&kc->kc_empty, s);
+	}
+	kc->kc_frees++;
+	kc->kc_inuse--;
+	restore(ps);
+	return(OK);
+}
+
+/*------------------------------------------------------------------------
+ *  kmem_cache_reap  --  give a cache's empty slabs back to the kernel
+ *			 heap, returning how many there were
+ *------------------------------------------------------------------------
+ */
+int	kmem_cache_reap(int c)
+{
+	STATWORD ps;
+	int	n;
+
+	disable(ps);
+	if (isbadkmc(c) || kmctab[c].kc_state != KMC_USED) {
+		restore(ps);
+		return(SYSERR);
+	}
+	n = km_release(&kmctab[c]);
+	restore(ps);
+	return(n);
+}
+
+/*------------------------------------------------------------------------
+ *  kmem_reap  --  reap every cache; getmem calls it before it fails
+ *------------------------------------------------------------------------
+ */
+int	kmem_reap(void)
+{
+	STATWORD ps;
+	int	c, n;
+
+	disable(ps);
+	for (n = c = 0; c < NKMCACHE; c++)
+		if (kmctab[c].kc_state == KMC_USED)
+			n += km_release(&kmctab[c]);
+	restore(ps);
+	return(n);
+}
+
+/*------------------------------------------------------------------------
+ *  kmem_print  --  print one line of statistics per cache
+ *------------------------------------------------------------------------
+ */
+void	kmem_print(void)
+{
+	struct	kmcache	*kc;
+	int	c;
+
+	for (c = 0; c < NKMCACHE; c++) {
+		kc = &kmctab[c];
+		if (kc->kc_state != KMC_USED)
+			continue;
+		kprintf("kmem %-11s size %u slab %u/%d slabs %lu inuse %lu "
+			"peak %lu allocs %lu frees %lu grows %lu reaps %lu "
+			"fails %lu\n", kc->kc_name, kc->kc_size,
+			kc->kc_slabsize, kc->kc_nobj, kc->kc_nslabs,
+			kc->kc_inuse, kc->kc_peak, kc->kc_allocs, kc->kc_frees,
+			kc->kc_grows, kc->kc_reaps, kc->kc_fails);
+	}
+}
+
+/*------------------------------------------------------------------------
+ *  km_grow  --  take a new slab for kc from the heap and construct its
+ *		 objects; if the heap is short, the kernel's caches are
+ *		 reclaimed first
+ *------------------------------------------------------------------------
+ */
+LOCAL	struct	kmslab	*km_grow(struct kmcache *kc)
+{
+	struct	kmslab	*s;
+	int	i;
+
+	s = (struct kmslab *) tlsf_memalign(kc->kc_slabsize, kc->kc_slabsize);
+	if (s == NULL && memreclaim() > 0)
+		s = (struct kmslab *) tlsf_memalign(kc->kc_slabsize,
+			kc->kc_slabsize);
+	if (s == NULL)
+		return(NULL);
+	s->sl_next = s->sl_prev = NULL;
+	s->sl_base = (char *) s + km_objoff(kc->kc_nobj, kc->kc_align);
+	s->sl_inuse = 0;
+	s->sl_nfree = kc->kc_nobj;
+	for (i = 0; i < kc->kc_nobj; i++) {	/* object 0 is handed out first */
+		s->sl_free[i] = kc->kc_nobj - 1 - i;
+		if (kc->kc_ctor != NULL)
+			(*kc->kc_ctor)(s->sl_base + i * kc->kc_size);
+	}
+	kc->kc_nslabs++;
+	kc->kc_grows++;
+	return(s);
+}
+
+/*------------------------------------------------------------------------
+ *  km_release  --  free every empty slab of kc, returning the count
+ *------------------------------------------------------------------------
+ */
+LOCAL	int	km_release(struct kmcache *kc)
+{
+	struct	kmslab	*s;
+	int	n;
+
+	for (n = 0; (s = kc->kc_empty) != NULL; n++) {
+		km_unlink(&kc->kc_empty, s);
+		tlsf_free((char *) s, kc->kc_slabsize);
+		kc->kc_nslabs--;
+		kc->kc_reaps++;
+	}
+	return(n);
+}
+
+/*------------------------------------------------------------------------
+ *  km_unlink, km_link  --  take a slab off a list, put one on the front
+ *------------------------------------------------------------------------
+ */
+LOCAL	void	km_unlink(struct kmslab **list, struct kmslab *s)
+{
+	if (s->sl_prev != NULL)
+		s->sl_prev->sl_next = s->sl_next;
+	else
+		*list = s->sl_next;
+	if (s->sl_next != NULL)
+		s->sl_next->sl_prev = s->sl_prev;
+	s->sl_next = s->sl_prev = NULL;
+}
+
+LOCAL	void	km_link(struct kmslab **list, struct kmslab *s)
+{
+	s->sl_prev = NULL;
+	if ((s->sl_next = *list) != NULL)
+		s->sl_next->sl_prev = s;
+	*list = s;
+}
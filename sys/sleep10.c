@@ -20,9 +20,7 @@ SYSCALL	sleep10(int n)
 	if (n == 0) {		/* sleep10(0) -> end time slice */
 	        ;
 	} else {
-		insertd(currpid,clockq,n*100);
-		slnempty = TRUE;
-		sltop = &q[q[clockq].qnext].qkey;
+		twinsert(currpid, n * 100);
 		proctab[currpid].pstate = PRSLEEP;
 	}
 	resched();
@@ -21,9 +21,7 @@ SYSCALL sleep100(int n)
 	if (n == 0) {		/* sleep100(0) -> end time slice */
 	        ;
 	} else {
-		insertd(currpid,clockq,n*10);
-		slnempty = TRUE;
-		sltop = &q[q[clockq].qnext].qkey;
+		twinsert(currpid, n * 10);
 		proctab[currpid].pstate = PRSLEEP;
 	}
 	resched();
@@ -21,9 +21,7 @@ SYSCALL sleep1000(int n)
 	if (n == 0) {		/* sleep1000(0) -> end time slice */
 	        ;
 	} else {
-		insertd(currpid,clockq,n);
-		slnempty = TRUE;
-		sltop = &q[q[clockq].qnext].qkey;
+		twinsert(currpid, n);
 		proctab[currpid].pstate = PRSLEEP;
 	}
 	resched();
@@ -25,7 +25,6 @@ int strtclk()
 {
 	STATWORD ps;    
 	int makeup;
-	int next;
 
 	disable(ps);
 	if ( defclk<=0 || --defclk>0 ) {
@@ -35,18 +34,7 @@ int strtclk()
 	makeup = clkdiff;
 	preempt -= makeup;
 	clkdiff = 0;
-	if ( slnempty ) {
-		for (next=firstid(clockq) ; 
-		    next < NPROC && q[next].qkey < makeup ;
-		    next=q[next].qnext) {
-			makeup -= q[next].qkey;
-			q[next].qkey = 0;
-		}
-		if (next < NPROC)
-			q[next].qkey -= makeup;
-		wakeup();
-	}
-	if ( preempt <= 0 )
+	if ( (slnempty && twadvance(makeup) > 0) || preempt <= 0 )
 	        resched();
 	restore(ps);
 }
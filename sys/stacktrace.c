@@ -21,6 +21,8 @@ SYSCALL stacktrace(int pid)
 
 	if (pid != 0 && isbadpid(pid))
 		return SYSERR;
+	if (pid != currpid && proc->pvstk > 0)
+		return SYSERR;		/* in another address space */
 	if (pid == currpid) {
 		asm("movl %esp,esp");
 		asm("movl %ebp,ebp");
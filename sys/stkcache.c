@@ -0,0 +1,139 @@
+/* stkcache.c - stkc_get, stkc_put, stkc_reclaim, stkc_setcap, stkc_print */
+
+#include <conf.h>
+#include <kernel.h>
+#include <mem.h>
+#include <stdio.h>
+
+/*
+ * Stacks freed by kill() are kept on a short list per stack size so the
+ * next create() of that size reuses one without going to the heap.  A
+ * kept stack is linked through its lowest word.  At most stkc_cap stacks
+ * of a size and STKCACHEMAX bytes in all are kept; anything more goes
+ * straight back to the heap, and memreclaim() empties the cache when
+ * the heap runs short.  create() stamps MAGIC on every stack it gets,
+ * so a reused stack is checked like a new one.
+ */
+
+struct	stkclass	{
+	unsigned	sc_size;	/* block size; 0 if class unused */
+	int	sc_count;		/* stacks on sc_head		*/
+	struct	mblock	*sc_head;
+	};
+
+LOCAL	struct	stkclass	stkc[NSTKCLASS];
+LOCAL	unsigned	stkc_bytes;		/* kept, all classes	*/
+LOCAL	int	stkc_cap = STKCACHEN;		/* kept per class	*/
+LOCAL	unsigned long	stkc_hits, stkc_misses, stkc_kept, stkc_freed;
+
+/*------------------------------------------------------------------------
+ *  stkc_get  --  take a cached stack block of size bytes (a multiple of
+ *		  the mblock size), or NULL.  Interrupts are disabled.
+ *------------------------------------------------------------------------
+ */
+char	*stkc_get(unsigned size)
+{
+	struct	stkclass	*sc;
+	struct	mblock	*b;
+
+	for (sc = &stkc[0]; sc < &stkc[NSTKCLASS]; sc++)
+		if (sc->sc_size == size && sc->sc_count > 0) {
+			b = sc->sc_head;
+			sc->sc_head = b->mnext;
+			sc->sc_count--;
+			stkc_bytes -= size;
+			stkc_hits++;
+			return((char *) b);
+		}
+	stkc_misses++;
+	return(NULL);
+}
+
+/*------------------------------------------------------------------------
+ *  stkc_put  --  keep a freed stack block of size bytes for reuse, or
+ *		  free it if the cache is full
+ *------------------------------------------------------------------------
+ */
+int	stkc_put(struct mblock *block, unsigned size)
+{
+	STATWORD ps;
+	struct	stkclass	*sc, *unused;
+
+	disable(ps);
+	unused = NULL;
+	for (sc = &stkc[0]; sc < &stkc[NSTKCLASS]; sc++)
+		if (sc->sc_size == size)
+			break;
+		else if (unused == NULL && sc->sc_count == 0)
+			unused = sc;
+	if (sc >= &stkc[NSTKCLASS])
+		sc = unused;
+	if (sc == NULL || sc->sc_count >= stkc_cap ||
+	    stkc_bytes + size > STKCACHEMAX) {
+		stkc_freed++;
+		restore(ps);
+		return(freemem(block, size));
+	}
+	sc->sc_size = size;
+	block->mnext = sc->sc_head;
+	block->mlen = size;
+	sc->sc_head = block;
+	sc->sc_count++;
+	stkc_bytes += size;
+	stkc_kept++;
+	restore(ps);
+	return(OK);
+}
+
+/*------------------------------------------------------------------------
+ *  stkc_reclaim  --  free every cached stack, returning how many
+ *------------------------------------------------------------------------
+ */
+int	stkc_reclaim(void)
+{
+	STATWORD ps;
+	struct	stkclass	*sc;
+	struct	mblock	*b;
+	int	n;
+
+	disable(ps);
+	n = 0;
+	for (sc = &stkc[0]; sc < &stkc[NSTKCLASS]; sc++)
+		while ((b = sc->sc_head) != NULL) {
+			sc->sc_head = b->mnext;
+			sc->sc_count--;
+			stkc_bytes -= sc->sc_size;
+			freemem(b, sc->sc_size);
+			n++;
+		}
+	restore(ps);
+	return(n);
+}
+
+/*------------------------------------------------------------------------
+ *  stkc_setcap  --  set how many stacks of a size are kept (0 turns the
+ *		     cache off) and return the old limit
+ *------------------------------------------------------------------------
+ */
+int	stkc_setcap(int cap)
+{
+	int	old;
+
+	if (cap < 0)
+		return(SYSERR);
+	old = stkc_cap;
+	stkc_cap = cap;
+	if (cap < old)
+		stkc_reclaim();
+	return(old);
+}
+
+/*------------------------------------------------------------------------
+ *  stkc_print  --  print the stack cache counters
+ *------------------------------------------------------------------------
+ */
+void	stkc_print(void)
+{
+	kprintf("stkcache hits %lu misses %lu kept %lu freed %lu bytes %u\n",
+		stkc_hits, stkc_misses, stkc_kept, stkc_freed, stkc_bytes);
+}
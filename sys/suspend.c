@@ -24,7 +24,7 @@ SYSCALL	suspend(int pid)
 	}
 	if (pptr->pstate == PRREADY) {
 		pptr->pstate = PRSUSP;
-		dequeue(pid);
+		schremove(pid);
 	}
 	else {
 		pptr->pstate = PRSUSP;
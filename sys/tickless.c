@@ -0,0 +1,287 @@
+/* tickless.c - settickless, clkstat_print, clksync, clkarm, clkexpire,
+ *		clkread */
+
+#include <conf.h>
+#include <kernel.h>
+#include <proc.h>
+#include <sleep.h>
+#include <icu.h>
+#include <edf.h>
+#include <timer.h>
+#include <paging.h>
+#include <stdio.h>
+
+/*
+ * The 8254 normally interrupts every ms (rate generator, mode 2).  When
+ * the null process runs, or one process runs with nobody else ready,
+ * those ticks have nothing to do until the next sleeper wakes, the next
+ * EDF period starts or, for a lone process, its quantum ends.  resched()
+ * then calls clkarm(), which reprograms the chip for a single interrupt
+ * that far off (interrupt on terminal count, mode 0), at most CLKMAXSHOT
+ * ms.  clkend holds where that interrupt comes, in counts from the last
+ * ms that ctr1000 accounts; clkexpire() adds the ms it stands for to
+ * ctr1000, clktime, the sleep wheel, EDF and preempt in one go, as that
+ * many ticks would have.  While a microsecond timer is set (timer.c)
+ * the clock runs one-shots even for a process that needs ticks, each
+ * ending at the next ms or at the timer, whichever is first, so that
+ * clkexpire() can run the timer on time.
+ *
+ * When another process gets ready before then, resched() calls
+ * clksync() first, which reads the chip's count and accounts the whole
+ * ms that have passed, and clkarm() then sets a last one-shot to the
+ * next ms boundary, whose interrupt goes back to 1 ms ticks.  The ticks
+ * then run the latency of that interrupt behind (clkfrac), which the
+ * next one-shot makes up, so no time is lost.  Nothing is read
+ * or reprogrammed while an interrupt is due (pending in the 8259, or
+ * less than CLKGUARD counts off), so the interrupt and the code that
+ * reprograms the chip never count the same ms.  A switch the pager
+ * held off (pgresched, see pglock.c) wants the next ms too.
+ */
+
+#define	CLKGUARD	64		/* counts, about 54 us		*/
+#define	CLKLOAD		5		/* counts from latching the count */
+					/*  to a new one starting: five	*/
+					/*  i/o instructions		*/
+#define	CLKLATCH	0x00		/* CSW: latch counter 0		*/
+#define	CLKSTATUS	0xe2		/* CSW: read back counter 0 status */
+#define	CLKMODE0	0x30		/* CSW: counter 0, lsb/msb, mode 0 */
+#define	CLKMODE2	0x34		/* CSW: counter 0, lsb/msb, mode 2 */
+#define	CLKOUT		0x80		/* status: OUT high, count done	*/
+
+int	clkshot = CLK_PERIODIC;
+unsigned long	clkints;		/* clock interrupts taken	*/
+LOCAL	int	tickless = TRUE;
+LOCAL	unsigned long	clkshots;	/* one-shots that expired	*/
+LOCAL	unsigned long	clkend;		/* counts the one-shot ends at	*/
+LOCAL	int	clkwanted;		/* clkwant() it was set for	*/
+LOCAL	unsigned long long clkdue;	/* tmdue() it was set for	*/
+LOCAL	long	clkskew;		/* counts accounted beyond where */
+					/*  the one-shot ended		*/
+LOCAL	unsigned long	clkfrac;	/* counts ticks run behind ms	*/
+
+LOCAL	int	clkaccount(unsigned long);
+LOCAL	int	clkwant(void);
+LOCAL	void	clkset(int, unsigned long);
+
+/*------------------------------------------------------------------------
+ *  settickless  --  turn tickless operation on or off, returning the
+ *		     old setting
+ *------------------------------------------------------------------------
+ */
+SYSCALL	settickless(int on)
+{
+	STATWORD ps;
+	int	old;
+
+	disable(ps);
+	old = tickless;
+	tickless = on ? TRUE : FALSE;
+	clkarm();
+	restore(ps);
+	return(old);
+}
+
+/*------------------------------------------------------------------------
+ *  clkstat_print  --  print how many interrupts the clock took
+ *------------------------------------------------------------------------
+ */
+void	clkstat_print(void)
+{
+	kprintf("clock ms %lu interrupts %lu one-shots %lu tickless %s\n",
+		ctr1000, clkints, clkshots, tickless ? "on" : "off");
+	kprintf("clock tsc %lu kHz timers set %d\n", tsckhz, tmcount);
+}
+
+/*------------------------------------------------------------------------
+ *  clksync  --  account the whole ms a running one-shot has covered so
+ *		 far; interrupts are disabled
+ *------------------------------------------------------------------------
+ */
+void	clksync(void)
+{
+	unsigned long	c, ms;
+
+	if (clkshot != CLK_ONESHOT || (c = clkread()) < CLKGUARD)
+		return;
+	outb(CLKCNTL, CLKSTATUS);
+	if (inb(CLOCK0) & CLKOUT)
+		return;			/* expired: clkexpire() is due	*/
+	outb(OCR, RDIRR);
+	if (inb(OCR) & 1)
+		return;
+	if ((ms = (clkend - c) / CLKCOUNTS) > 0) {
+		clkend -= ms * CLKCOUNTS;
+		if (clkwanted > 0)	/* counted from ctr1000 too	*/
+			clkwanted -= ms;
+		clkaccount(ms);
+	}
+}
+
+/*------------------------------------------------------------------------
+ *  clkarm  --  program the clock for the process now running and the
+ *		timers set: a one-shot if it runs alone or a timer is
+ *		set, else 1 ms ticks
+ *------------------------------------------------------------------------
+ */
+void	clkarm(void)
+{
+	unsigned long long due;
+	unsigned long	c, e, n, t;
+	int	want;
+
+	want = clkwant();
+	due = tmdue();
+	if (clkshot == CLK_PERIODIC ? want == 0 && due == TM_NEVER :
+	    clkshot == CLK_ONESHOT && want == clkwanted && due == clkdue)
+		return;			/* as it is			*/
+	if (clkshot != CLK_STOPPED) {
+		if (clkread() < CLKGUARD)
+			return;		/* the clock interrupt is due	*/
+		if (clkshot == CLK_ONESHOT) {
+			outb(CLKCNTL, CLKSTATUS);
+			if (inb(CLOCK0) & CLKOUT)
+				return;
+		}
+		outb(OCR, RDIRR);
+		if (inb(OCR) & 1)
+			return;
+	}
+	c = clkread();			/* the new count starts CLKLOAD	*/
+	switch (clkshot) {		/*  counts after this		*/
+
+	case CLK_PERIODIC:
+		e = CLKCOUNTS - c + clkfrac + CLKLOAD;	/* since last ms */
+		break;
+
+	case CLK_STOPPED:
+		e = ((0x10000 - c) & 0xffff) - clkskew + CLKLOAD;
+		if (want == 0 && due == TM_NEVER && e < CLKGUARD) {
+			clkset(CLKMODE2, CLKCOUNTS);
+			clkshot = CLK_PERIODIC;
+			clkfrac = e;	/* made up by the next one-shot	*/
+			return;
+		}
+		break;
+
+	default:
+		e = clkend - c + CLKLOAD;
+		break;
+	}
+	n = want > 0 ? want : e / CLKCOUNTS + 1;	/* or the next ms */
+	if (n * CLKCOUNTS < e + CLKGUARD)
+		n = (e + CLKGUARD) / CLKCOUNTS + 1;
+	n *= CLKCOUNTS;
+	if ((t = tmcounts()) < n - e)	/* a timer comes first		*/
+		n = e + (t > CLKGUARD ? t : CLKGUARD);
+	clkset(CLKMODE0, n - e);
+	clkshot = CLK_ONESHOT;
+	clkend = n;
+	clkwanted = want;
+	clkdue = due;
+	clkfrac = 0;
+}
+
+/*------------------------------------------------------------------------
+ *  clkexpire  --  called by the clock interrupt when a one-shot is set
+ *------------------------------------------------------------------------
+ */
+INTPROC	clkexpire(void)
+{
+	unsigned long	over, ms;
+	int	resch;
+
+	outb(CLKCNTL, CLKSTATUS);
+	if (!(inb(CLOCK0) & CLKOUT))
+		return(OK);		/* an old tick; wait for it	*/
+	over = (0x10000 - clkread()) & 0xffff;	/* counts since	*/
+	ms = (clkend + over) / CLKCOUNTS;
+	clkskew = (long) (ms * CLKCOUNTS) - (long) clkend;
+	clkshot = CLK_STOPPED;
+	clkshots++;
+	resch = clkaccount(ms);
+	if (tmcount > 0 && tmexpire() > 0)
+		resch = TRUE;
+	if (resch)
+		resched();
+	else
+		clkarm();
+	return(OK);
+}
+
+/*------------------------------------------------------------------------
+ *  clkaccount  --  do what ms clock ticks would have done, but without
+ *		    rescheduling; TRUE if a reschedule is due
+ *------------------------------------------------------------------------
+ */
+LOCAL	int	clkaccount(unsigned long ms)
+{
+	unsigned long	r;
+	int	resch;
+
+	ctr1000 += ms;
+	if (ms >= count1000) {
+		r = ms - count1000;
+		clktime += 1 + r / 1000;
+		count1000 = 1000 - r % 1000;
+	} else
+		count1000 -= ms;
+	resch = FALSE;
+	if (ctr1000 >= edfnext && edfadvance())
+		resch = TRUE;
+	if (slnempty && twadvance(ms) > 0)
+		resch = TRUE;
+	if ((preempt -= (int) ms) <= 0)
+		resch = TRUE;
+	if (pgresched)			/* one the pager held off	*/
+		resch = TRUE;
+	return(resch);
+}
+
+/*------------------------------------------------------------------------
+ *  clkwant  --  return the ms the running process can go without a
+ *		 tick, or 0 if it needs them
+ *------------------------------------------------------------------------
+ */
+LOCAL	int	clkwant(void)
+{
+	unsigned long	ms, t;
+
+	if (!tickless || pgresched ||
+	    (currpid != NULLPROC && !schalone()))
+		return(0);
+	ms = CLKMAXSHOT;
+	if (currpid != NULLPROC && preempt < (int) ms)
+		ms = preempt > 0 ? preempt : 0;
+	if ((t = twnext()) < ms)
+		ms = t;
+	if (edfnext != EDF_NONE) {
+		t = edfnext > ctr1000 ? edfnext - ctr1000 : 0;
+		if (t < ms)
+			ms = t;
+	}
+	return(ms > 1 ? (int) ms : 0);
+}
+
+/*------------------------------------------------------------------------
+ *  clkread  --  return counter 0's current count
+ *------------------------------------------------------------------------
+ */
+unsigned long	clkread(void)
+{
+	unsigned long	lsb;
+
+	outb(CLKCNTL, CLKLATCH);
+	lsb = inb(CLOCK0) & 0xff;
+	return(lsb | (inb(CLOCK0) & 0xff) << 8);
+}
+
+/*------------------------------------------------------------------------
+ *  clkset  --  start counter 0 in the given mode with count counts
+ *------------------------------------------------------------------------
+ */
+LOCAL	void	clkset(int mode, unsigned long count)
+{
+	outb(CLKCNTL, mode);
+	outb(CLOCK0, count & 0xff);
+	outb(CLOCK0, count >> 8);
+}
@@ -0,0 +1,257 @@
+/* timer.c - tminit, tmcreate, tmstart, tmcancel, tmdelete, sleepus,
+ *	     tminsert, tmremove, tmdue, tmcounts, tmexpire */
+
+#include <conf.h>
+#include <kernel.h>
+#include <proc.h>
+#include <sleep.h>
+#include <timer.h>
+#include <stdio.h>
+
+/*
+ * One-shot timers with microsecond resolution, timed by gettime_ns().
+ * A set timer is on tmfirst's list, which is kept in the order the
+ * timers fire; there are few, so inserting walks it.  While any is set
+ * the clock runs one-shots (see clkarm() in tickless.c) that end at the
+ * next ms or at the first timer, whichever comes first, and clkexpire()
+ * calls tmexpire() to run the timers whose time has come.  The clock
+ * interrupt arms that one-shot within a ms of a timer being set while
+ * it was ticking.
+ *
+ * Slot pid belongs to process pid: sleepus() sets it to make the
+ * process ready again, and unsleep() (so kill() too) takes it off.
+ * tmcreate() hands out the NTIMER slots after those.
+ */
+
+#define	TM_FARNS	60000000UL	/* ns: further than any one-shot */
+#define	TM_NSCOUNT	5124096ULL	/* 8254 counts per ns, << 32	*/
+
+struct	tmentry	tmtab[NPROC + NTIMER];
+int	tmcount;			/* timers on the list		*/
+LOCAL	int	tmfirst = TM_NONE;	/* first timer to fire		*/
+LOCAL	int	tmnextfree;		/* where tmcreate() looks first	*/
+
+LOCAL	void	tmwake(int);
+
+/*------------------------------------------------------------------------
+ *  tminit  --  give each process its timer and free the others
+ *------------------------------------------------------------------------
+ */
+void	tminit(void)
+{
+	int	t;
+
+	for (t = 0; t < NPROC + NTIMER; t++) {
+		tmtab[t].tmstate = t < NPROC ? TM_IDLE : TM_FREE;
+		tmtab[t].tmfunc = tmwake;
+		tmtab[t].tmarg = t;
+	}
+	tmfirst = TM_NONE;
+	tmcount = 0;
+	tmnextfree = NPROC;
+}
+
+/*------------------------------------------------------------------------
+ *  tmcreate  --  allocate a timer that calls func(arg) when it fires
+ *------------------------------------------------------------------------
+ */
+SYSCALL	tmcreate(void (*func)(int), int arg)
+{
+	STATWORD ps;
+	int	i, t;
+
+	disable(ps);
+	for (i = 0; i < NTIMER && func != NULL; i++) {
+		t = tmnextfree;
+		if (++tmnextfree >= NPROC + NTIMER)
+			tmnextfree = NPROC;
+		if (tmtab[t].tmstate == TM_FREE) {
+			tmtab[t].tmstate = TM_IDLE;
+			tmtab[t].tmfunc = func;
+			tmtab[t].tmarg = arg;
+			restore(ps);
+			return(t);
+		}
+	}
+	restore(ps);
+	return(SYSERR);
+}
+
+/*------------------------------------------------------------------------
+ *  tmstart  --  set timer tm to fire us microseconds from now, instead
+ *		 of when it was set for if it is set
+ *------------------------------------------------------------------------
+ */
+SYSCALL	tmstart(int tm, unsigned long us)
+{
+	STATWORD ps;
+
+	disable(ps);
+	if (isbadtm(tm) || tmtab[tm].tmstate == TM_FREE || tsckhz == 0) {
+		restore(ps);
+		return(SYSERR);
+	}
+	if (tmtab[tm].tmstate == TM_SET)
+		tmremove(tm);
+	tminsert(tm, gettime_ns() + (unsigned long long) us * 1000);
+	restore(ps);
+	return(OK);
+}
+
+/*------------------------------------------------------------------------
+ *  tmcancel  --  stop timer tm from firing; OK if it was set
+ *------------------------------------------------------------------------
+ */
+SYSCALL	tmcancel(int tm)
+{
+	STATWORD ps;
+
+	disable(ps);
+	if (isbadtm(tm) || tmtab[tm].tmstate != TM_SET) {
+		restore(ps);
+		return(SYSERR);
+	}
+	tmremove(tm);
+	restore(ps);
+	return(OK);
+}
+
+/*------------------------------------------------------------------------
+ *  tmdelete  --  cancel timer tm if it is set and free it
+ *------------------------------------------------------------------------
+ */
+SYSCALL	tmdelete(int tm)
+{
+	STATWORD ps;
+
+	disable(ps);
+	if (isbadtm(tm) || tmtab[tm].tmstate == TM_FREE) {
+		restore(ps);
+		return(SYSERR);
+	}
+	if (tmtab[tm].tmstate == TM_SET)
+		tmremove(tm);
+	tmtab[tm].tmstate = TM_FREE;
+	restore(ps);
+	return(OK);
+}
+
+/*------------------------------------------------------------------------
+ *  sleepus  --  delay the caller for us microseconds
+ *------------------------------------------------------------------------
+ */
+SYSCALL	sleepus(unsigned long us)
+{
+	STATWORD ps;
+
+	if (clkruns == 0 || tsckhz == 0)
+		return(SYSERR);
+	disable(ps);
+	if (us > 0) {		/* sleepus(0) -> end time slice	*/
+		tminsert(currpid, gettime_ns() +
+			(unsigned long long) us * 1000);
+		proctab[currpid].pstate = PRSLEEP;
+	}
+	resched();
+	restore(ps);
+	return(OK);
+}
+
+/*------------------------------------------------------------------------
+ *  tminsert  --  put timer t on the list to fire at gettime_ns() when;
+ *		  interrupts are disabled
+ *------------------------------------------------------------------------
+ */
+void	tminsert(int t, unsigned long long when)
+{
+	int	*next;
+
+	tmtab[t].tmwhen = when;
+	for (next = &tmfirst; *next != TM_NONE &&
+	     tmtab[*next].tmwhen <= when; next = &tmtab[*next].tmnext)
+		;
+	tmtab[t].tmnext = *next;
+	*next = t;
+	tmtab[t].tmstate = TM_SET;
+	tmcount++;
+	clkarm();			/* it may be due before the tick */
+}
+
+/*------------------------------------------------------------------------
+ *  tmremove  --  take set timer t off the list
+ *------------------------------------------------------------------------
+ */
+void	tmremove(int t)
+{
+	int	*next;
+
+	for (next = &tmfirst; *next != t; next = &tmtab[*next].tmnext)
+		;
+	*next = tmtab[t].tmnext;
+	tmtab[t].tmstate = TM_IDLE;
+	tmcount--;
+}
+
+/*------------------------------------------------------------------------
+ *  tmdue  --  return when the first timer fires, TM_NEVER if none is set
+ *------------------------------------------------------------------------
+ */
+unsigned long long	tmdue(void)
+{
+	return(tmfirst == TM_NONE ? TM_NEVER : tmtab[tmfirst].tmwhen);
+}
+
+/*------------------------------------------------------------------------
+ *  tmcounts  --  return the 8254 counts to when the first timer fires,
+ *		  rounded up, or 0x10000 if that is beyond any one-shot
+ *------------------------------------------------------------------------
+ */
+unsigned long	tmcounts(void)
+{
+	unsigned long long now;
+	unsigned long	ns, c;
+
+	if (tmfirst == TM_NONE)
+		return(0x10000);
+	now = gettime_ns();
+	if (tmtab[tmfirst].tmwhen <= now)
+		return(0);
+	if (tmtab[tmfirst].tmwhen - now >= TM_FARNS)
+		return(0x10000);
+	ns = (unsigned long) (tmtab[tmfirst].tmwhen - now);
+	c = (unsigned long) (((unsigned long long) ns * TM_NSCOUNT) >> 32);
+	return(c + (c >> 12) + 2);	/* never early, though the TSC	*/
+					/*  was measured 1/4096 off	*/
+}
+
+/*------------------------------------------------------------------------
+ *  tmexpire  --  run every timer whose time has come, without
+ *		  rescheduling, and return how many there were
+ *------------------------------------------------------------------------
+ */
+int	tmexpire(void)
+{
+	unsigned long long now;
+	int	t, fired;
+
+	now = gettime_ns();
+	for (fired = 0; tmfirst != TM_NONE && tmtab[tmfirst].tmwhen <= now;
+	     fired++) {
+		t = tmfirst;
+		tmfirst = tmtab[t].tmnext;
+		tmtab[t].tmstate = TM_IDLE;
+		tmcount--;
+		(*tmtab[t].tmfunc)(tmtab[t].tmarg);
+	}
+	return(fired);
+}
+
+/*------------------------------------------------------------------------
+ *  tmwake  --  what a process's own timer calls: the sleepus() is over
+ *------------------------------------------------------------------------
+ */
+LOCAL	void	tmwake(int pid)
+{
+	if (proctab[pid].pstate == PRSLEEP)
+		ready(pid, RESCHNO);
+}
@@ -0,0 +1,361 @@
+/* tlsf.c - tlsf_init, tlsf_addpool, tlsf_alloc, tlsf_memalign, tlsf_free,
+ *	    getmemstat, memstat_print */
+
+#include <conf.h>
+#include <kernel.h>
+#include <mem.h>
+#include <stdio.h>
+
+/*
+ * The kernel heap is a two-level segregated fit allocator.  Free blocks
+ * sit on one of TL_NFL x TL_NSL lists: the first level is the power of
+ * two below the block size, the second splits that range into TL_NSL
+ * equal steps (sizes under TL_SMALL share one first-level row of 8-byte
+ * steps).  A bitmap per level marks the non-empty lists, so finding a
+ * block that fits takes two bit scans.  Every block starts with a
+ * boundary tag, the previous block in memory and its own size, so a
+ * freed block merges with free neighbours without any list walk.  All
+ * operations are O(1); the callers keep interrupts off only that long.
+ */
+
+#define	TL_SLLOG	4		/* log2 of second-level lists	*/
+#define	TL_NSL		(1 << TL_SLLOG)
+#define	TL_FLSHIFT	(TL_SLLOG + 3)	/* sizes are multiples of 8	*/
+#define	TL_SMALL	(1 << TL_FLSHIFT) /* sizes below use row 0	*/
+#define	TL_NFL		20		/* rows; blocks under 32 MB	*/
+#define	TL_MAXSIZE	((1UL << (TL_NFL + TL_FLSHIFT - 1)) - 1)
+
+struct	tlblk	{			/* block header (boundary tag)	*/
+	struct	tlblk	*tb_prevphys;	/* block before this in memory	*/
+	unsigned	tb_size;	/* payload bytes | TB_ flags	*/
+	struct	tlblk	*tb_next;	/* free list links; while the	*/
+	struct	tlblk	*tb_prev;	/*   block is in use, payload	*/
+	};
+
+#define	TL_HDR		((unsigned) &((struct tlblk *) 0)->tb_next)
+					/* header of a used block	*/
+#define	TL_MINBLK	(sizeof(struct tlblk) - TL_HDR)	/* room for links */
+#define	TB_FREE		0x1		/* block is free		*/
+#define	TB_PFREE	0x2		/* block before it is free	*/
+#define	TB_SIZE(b)	((b)->tb_size & ~3)
+#define	TB_NEXT(b)	((struct tlblk *) ((char *) (b) + TL_HDR + TB_SIZE(b)))
+
+struct	memstat	memstat;		/* heap counters		*/
+
+LOCAL	unsigned	tl_flmap;		/* non-empty rows	*/
+LOCAL	unsigned	tl_slmap[TL_NFL];	/* non-empty lists	*/
+LOCAL	struct	tlblk	*tl_head[TL_NFL][TL_NSL];
+LOCAL	char	*tl_lo, *tl_hi;			/* bounds of all pools	*/
+
+LOCAL	void	tl_mapping(unsigned, int *, int *);
+LOCAL	void	tl_insert(struct tlblk *);
+LOCAL	void	tl_remove(struct tlblk *);
+
+#define	tl_fls(x)	(31 - __builtin_clz(x))	/* highest set bit (bsr) */
+#define	tl_ffs(x)	__builtin_ctz(x)	/* lowest set bit (bsf)	 */
+
+/*------------------------------------------------------------------------
+ *  tlsf_init  --  start with an empty heap
+ *------------------------------------------------------------------------
+ */
+void	tlsf_init(void)
+{
+	int	i, j;
+
+	tl_flmap = 0;
+	for (i = 0; i < TL_NFL; i++) {
+		tl_slmap[i] = 0;
+		for (j = 0; j < TL_NSL; j++)
+			tl_head[i][j] = NULL;
+	}
+	tl_lo = tl_hi = NULL;
+	bzero(&memstat, sizeof(memstat));
+}
+
+/*------------------------------------------------------------------------
+ *  tlsf_addpool  --  give the heap len bytes of memory at start.  The
+ *		      pool ends in a zero-size used block so merging
+ *		      never runs off the end.
+ *------------------------------------------------------------------------
+ */
+void	tlsf_addpool(char *start, unsigned len)
+{
+	struct	tlblk	*b, *sentinel;
+	char	*top;
+
+	top = (char *) truncmb(start + len);
+	start = (char *) roundmb(start);
+	if (top <= start || top - start < 2 * TL_HDR + TL_MINBLK)
+		return;
+	while (top - start - 2 * TL_HDR > TL_MAXSIZE) {	/* split huge pools */
+		tlsf_addpool(start, TL_MAXSIZE & ~7);
+		start += TL_MAXSIZE & ~7;
+	}
+	b = (struct tlblk *) start;
+	b->tb_prevphys = NULL;
+	b->tb_size = (top - start - 2 * TL_HDR) | TB_FREE;
+	sentinel = TB_NEXT(b);
+	sentinel->tb_prevphys = b;
+	sentinel->tb_size = TB_PFREE;
+	tl_insert(b);
+	if (tl_lo == NULL || start < tl_lo)
+		tl_lo = start;
+	if (top > tl_hi)
+		tl_hi = top;
+}
+
+/*------------------------------------------------------------------------
+ *  tlsf_alloc  --  take a block of at least nbytes, or NULL.  Called
+ *		    with interrupts disabled.
+ *------------------------------------------------------------------------
+ */
+char	*tlsf_alloc(unsigned nbytes)
+{
+	struct	tlblk	*b, *rest;
+	unsigned	size, map;
+	int	fl, sl;
+
+	size = (unsigned) roundmb(nbytes);
+	if (size < TL_MINBLK)
+		size = TL_MINBLK;
+	if (nbytes == 0 || size > TL_MAXSIZE / 2) {
+		memstat.ms_fail++;
+		return(NULL);
+	}
+
+	/* search from the list after size's own, where any block fits */
+	if (size >= TL_SMALL)
+		tl_mapping(size + (1 << (tl_fls(size) - TL_SLLOG)) - 1,
+			&fl, &sl);
+	else
+		tl_mapping(size, &fl, &sl);
+	map = tl_slmap[fl] & (~0U << sl);
+	if (map == 0) {
+		map = tl_flmap & (~0U << fl << 1);
+		if (map == 0) {
+			memstat.ms_fail++;
+			return(NULL);
+		}
+		fl = tl_ffs(map);
+		map = tl_slmap[fl];
+	}
+	sl = tl_ffs(map);
+	b = tl_head[fl][sl];
+	tl_remove(b);
+
+	/* split off the tail if it can hold a free block */
+	if (TB_SIZE(b) - size >= TL_HDR + TL_MINBLK) {
+		rest = (struct tlblk *) ((char *) b + TL_HDR + size);
+		rest->tb_prevphys = b;
+		rest->tb_size = (TB_SIZE(b) - size - TL_HDR) | TB_FREE;
+		TB_NEXT(rest)->tb_prevphys = rest;
+		b->tb_size = size | (b->tb_size & TB_PFREE);
+		tl_insert(rest);
+	}
+	memstat.ms_used += TB_SIZE(b);
+	memstat.ms_nused++;
+	if (memstat.ms_used > memstat.ms_peak)
+		memstat.ms_peak = memstat.ms_used;
+	return((char *) b + TL_HDR);
+}
+
+/*------------------------------------------------------------------------
+ *  tlsf_memalign  --  take a block of at least nbytes whose address is a
+ *		       multiple of align (a power of two), or NULL.  The
+ *		       slack on either side goes back to the heap, so the
+ *		       block is freed like any other.  Called with
+ *		       interrupts disabled.
+ *------------------------------------------------------------------------
+ */
+char	*tlsf_memalign(unsigned align, unsigned nbytes)
+{
+	struct	tlblk	*b, *nb;
+	unsigned	size, gap;
+	char	*p, *a;
+
+	if (align == 0 || (align & (align - 1)) != 0)
+		return(NULL);
+	if (align <= 8)				/* every block is */
+		return(tlsf_alloc(nbytes));
+	size = (unsigned) roundmb(nbytes);
+	if (size < TL_MINBLK)
+		size = TL_MINBLK;
+	if (nbytes == 0 || size + align > TL_MAXSIZE / 2 ||
+	    (p = tlsf_alloc(size + align + TL_HDR + TL_MINBLK)) == NULL)
+		return(NULL);
+	b = (struct tlblk *) (p - TL_HDR);
+
+	/* a gap in front must hold a free block of its own */
+	a = (char *) (((unsigned long) p + align - 1) &
+		~(unsigned long) (align - 1));
+	while (a != p && a - p < TL_HDR + TL_MINBLK)
+		a += align;
+	if (a != p) {
+		gap = a - p;
+		nb = (struct tlblk *) (a - TL_HDR);
+		nb->tb_prevphys = b;
+		nb->tb_size = TB_SIZE(b) - gap;
+		TB_NEXT(nb)->tb_prevphys = nb;
+		b->tb_size = (gap - TL_HDR) | (b->tb_size & TB_PFREE);
+		memstat.ms_used -= TL_HDR;
+		memstat.ms_nused++;
+		tlsf_free(p, 1);
+		b = nb;
+	}
+
+	/* and so must whatever is left past the end */
+	if (TB_SIZE(b) - size >= TL_HDR + TL_MINBLK) {
+		nb = (struct tlblk *) (a + size);
+		nb->tb_prevphys = b;
+		nb->tb_size = TB_SIZE(b) - size - TL_HDR;
+		TB_NEXT(nb)->tb_prevphys = nb;
+		b->tb_size = size | (b->tb_size & TB_PFREE);
+		memstat.ms_used -= TL_HDR;
+		memstat.ms_nused++;
+		tlsf_free((char *) nb + TL_HDR, 1);
+	}
+	return(a);
+}
+
+/*------------------------------------------------------------------------
+ *  tlsf_free  --  return a block of nbytes taken by tlsf_alloc, merging
+ *		   it with free neighbours.  Called with interrupts
+ *		   disabled.
+ *------------------------------------------------------------------------
+ */
+int	tlsf_free(char *p, unsigned nbytes)
+{
+	struct	tlblk	*b, *n;
+
+	if (p < tl_lo + TL_HDR || p >= tl_hi || ((unsigned) p & 7) != 0)
+		return(SYSERR);
+	b = (struct tlblk *) (p - TL_HDR);
+	if ((b->tb_size & TB_FREE) || TB_SIZE(b) < (unsigned) roundmb(nbytes))
+		return(SYSERR);
+	memstat.ms_used -= TB_SIZE(b);
+	memstat.ms_nused--;
+
+	if (b->tb_size & TB_PFREE) {		/* merge with the block below */
+		n = b->tb_prevphys;
+		tl_remove(n);
+		n->tb_size = (TB_SIZE(n) + TL_HDR + TB_SIZE(b)) |
+			(n->tb_size & TB_PFREE);
+		b = n;
+	}
+	n = TB_NEXT(b);
+	if (n->tb_size & TB_FREE) {		/* and with the one above */
+		tl_remove(n);
+		b->tb_size = (TB_SIZE(b) + TL_HDR + TB_SIZE(n)) |
+			(b->tb_size & TB_PFREE);
+	}
+	b->tb_size |= TB_FREE;
+	TB_NEXT(b)->tb_prevphys = b;
+	tl_insert(b);
+	return(OK);
+}
+
+/*------------------------------------------------------------------------
+ *  tl_mapping  --  first- and second-level list for a block of size
+ *------------------------------------------------------------------------
+ */
+LOCAL	void	tl_mapping(unsigned size, int *fl, int *sl)
+{
+	int	f;
+
+	if (size < TL_SMALL) {
+		*fl = 0;
+		*sl = size / (TL_SMALL / TL_NSL);
+	} else {
+		f = tl_fls(size);
+		*sl = (size >> (f - TL_SLLOG)) ^ TL_NSL;
+		*fl = f - (TL_FLSHIFT - 1);
+	}
+}
+
+/*------------------------------------------------------------------------
+ *  tl_insert  --  put free block b at the head of its list, and mark
+ *		   the block above it as following a free block
+ *------------------------------------------------------------------------
+ */
+LOCAL	void	tl_insert(struct tlblk *b)
+{
+	int	fl, sl;
+
+	tl_mapping(TB_SIZE(b), &fl, &sl);
+	b->tb_prev = NULL;
+	b->tb_next = tl_head[fl][sl];
+	if (b->tb_next != NULL)
+		b->tb_next->tb_prev = b;
+	tl_head[fl][sl] = b;
+	tl_flmap |= 1U << fl;
+	tl_slmap[fl] |= 1U << sl;
+	TB_NEXT(b)->tb_size |= TB_PFREE;
+	memstat.ms_free += TB_SIZE(b);
+	memstat.ms_nfree++;
+}
+
+/*------------------------------------------------------------------------
+ *  tl_remove  --  take free block b off its list
+ *------------------------------------------------------------------------
+ */
+LOCAL	void	tl_remove(struct tlblk *b)
+{
+	int	fl, sl;
+
+	tl_mapping(TB_SIZE(b), &fl, &sl);
+	if (b->tb_prev != NULL)
+		b->tb_prev->tb_next = b->tb_next;
+	else if ((tl_head[fl][sl] = b->tb_next) == NULL) {
+		tl_slmap[fl] &= ~(1U << sl);
+		if (tl_slmap[fl] == 0)
+			tl_flmap &= ~(1U << fl);
+	}
+	if (b->tb_next != NULL)
+		b->tb_next->tb_prev = b->tb_prev;
+	b->tb_size &= ~TB_FREE;
+	TB_NEXT(b)->tb_size &= ~TB_PFREE;
+	memstat.ms_free -= TB_SIZE(b);
+	memstat.ms_nfree--;
+}
+
+/*------------------------------------------------------------------------
+ *  getmemstat  --  copy the heap counters, with the largest free block
+ *		    and the fragmentation they imply
+ *------------------------------------------------------------------------
+ */
+int	getmemstat(struct memstat *ms)
+{
+	STATWORD ps;
+	struct	tlblk	*b;
+	int	fl, sl;
+
+	disable(ps);
+	memstat.ms_largest = 0;
+	if (tl_flmap != 0) {		/* only the top list can hold it */
+		fl = tl_fls(tl_flmap);
+		sl = tl_fls(tl_slmap[fl]);
+		for (b = tl_head[fl][sl]; b != NULL; b = b->tb_next)
+			if (TB_SIZE(b) > memstat.ms_largest)
+				memstat.ms_largest = TB_SIZE(b);
+	}
+	memstat.ms_frag = memstat.ms_free < 16 ? 0 : 1000 -
+		(memstat.ms_largest >> 4) * 1000 / (memstat.ms_free >> 4);
+	*ms = memstat;
+	restore(ps);
+	return(OK);
+}
+
+/*------------------------------------------------------------------------
+ *  memstat_print  --  print the kernel heap counters on the console
+ *------------------------------------------------------------------------
+ */
+void	memstat_print(void)
+{
+	struct	memstat	ms;
+
+	getmemstat(&ms);
+	kprintf("heap free %lu used %lu peak %lu freeblks %lu usedblks %lu "
+		"largest %lu fail %lu frag %lu/1000\n", ms.ms_free, ms.ms_used,
+		ms.ms_peak, ms.ms_nfree, ms.ms_nused, ms.ms_largest,
+		ms.ms_fail, ms.ms_frag);
+}
@@ -0,0 +1,75 @@
+/* tsc.c - tscinit, gettime_ns, tsc2ns */
+
+#include <conf.h>
+#include <kernel.h>
+#include <sleep.h>
+#include <paging.h>
+#include <timer.h>
+#include <stdio.h>
+
+/*
+ * gettime_ns() is a monotonic clock in ns since boot, read from the
+ * time stamp counter.  tscinit() measures the TSC against the 8254 at
+ * startup, counting cycles over TSC_CALTICKS of counter 0's 1 ms
+ * periods (TSC_CALNS ns of the chip's own clock), before clock
+ * interrupts are enabled.  Cycles become ns by a multiply and a shift.
+ */
+
+#define	TSC_CALTICKS	50		/* clock periods timed		*/
+#define	TSC_CALNS	(TSC_CALTICKS * CLKCOUNTS * 1000000000ULL / PIT_HZ)
+
+unsigned long	tsckhz;			/* TSC rate, kHz		*/
+unsigned long	tscmult;		/* ns per cycle << TSC_SHIFT	*/
+LOCAL	unsigned long long	tscbase;	/* TSC at calibration	*/
+
+/*------------------------------------------------------------------------
+ *  tscinit  --  calibrate the TSC against counter 0 of the 8254, which
+ *		 must be running 1 ms periods; interrupts are disabled
+ *------------------------------------------------------------------------
+ */
+void	tscinit(void)
+{
+	unsigned long long t0 = 0;
+	unsigned long	c, last, cyc;
+	int	n;
+
+	last = clkread();
+	for (n = -1; n < TSC_CALTICKS; ) {
+		if ((c = clkread()) > last) {	/* the count reloaded	*/
+			if (++n == 0)
+				t0 = read_tsc();
+		}
+		last = c;
+	}
+	cyc = (unsigned long) (read_tsc() - t0);
+	if (cyc <= (unsigned long) ((TSC_CALNS << TSC_SHIFT) >> 32)) {
+		kprintf("tsc: cannot calibrate (%lu cycles)\n", cyc);
+		return;			/* gettime_ns() stays 0		*/
+	}
+	tscmult = div64(TSC_CALNS << TSC_SHIFT, cyc);
+	tsckhz = div64((unsigned long long) cyc * 1000000, TSC_CALNS);
+	tscbase = read_tsc();
+}
+
+/*------------------------------------------------------------------------
+ *  gettime_ns  --  return ns since the TSC was calibrated
+ *------------------------------------------------------------------------
+ */
+unsigned long long	gettime_ns(void)
+{
+	return(tsc2ns(read_tsc() - tscbase));
+}
+
+/*------------------------------------------------------------------------
+ *  tsc2ns  --  convert TSC cycles to ns
+ *------------------------------------------------------------------------
+ */
+unsigned long long	tsc2ns(unsigned long long cycles)
+{
+	unsigned long	hi, lo;
+
+	hi = (unsigned long) (cycles >> 32);
+	lo = (unsigned long) cycles;
+	return((((unsigned long long) lo * tscmult) >> TSC_SHIFT) +
+		(((unsigned long long) hi * tscmult) << (32 - TSC_SHIFT)));
+}
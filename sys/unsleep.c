@@ -5,6 +5,7 @@
 #include <proc.h>
 #include <q.h>
 #include <sleep.h>
+#include <timer.h>
 #include <stdio.h>
 
 /*------------------------------------------------------------------------
@@ -15,9 +16,6 @@ SYSCALL	unsleep(int pid)
 {
 	STATWORD ps;    
 	struct	pentry	*pptr;
-	struct	qent	*qptr;
-	int	remain;
-	int	next;
 
         disable(ps);
 	if (isbadpid(pid) ||
@@ -26,15 +24,10 @@ SYSCALL	unsleep(int pid)
 		restore(ps);
 		return(SYSERR);
 	}
-	qptr = &q[pid];
-	remain = qptr->qkey;
-	if ( (next=qptr->qnext) < NPROC)
-		q[next].qkey += remain;
-	dequeue(pid);
-	if ( (next=q[clockq].qnext) < NPROC)
-		sltop = (int *) & q[next].qkey;
+	if (tmtab[pid].tmstate == TM_SET)
+		tmremove(pid);		/* in sleepus()			*/
 	else
-		slnempty = FALSE;
+		twremove(pid);
         restore(ps);
 	return(OK);
 }
@@ -12,10 +12,7 @@
  */
 INTPROC	wakeup()
 {
-        while (nonempty(clockq) && firstkey(clockq) <= 0)
-                ready(getfirst(clockq),RESCHNO);
-	if ((slnempty = nonempty(clockq)))
-		sltop = & q[q[clockq].qnext].qkey;
-	resched();
+	if (twadvance(1) > 0)
+		resched();
         return(OK);
 }
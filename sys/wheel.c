@@ -0,0 +1,137 @@
+/* wheel.c - twinit, twinsert, twremove, twadvance, twnext */
+
+#include <conf.h>
+#include <kernel.h>
+#include <proc.h>
+#include <q.h>
+#include <sleep.h>
+
+/*
+ * Sleeping processes (sleep10 and friends, recvtim) wait on a
+ * hierarchical timing wheel of TW_LEVELS levels of TW_SLOTS slots, each
+ * slot a list in q[].  Level 0 slots are one ms apart, level l slots
+ * TW_SLOTS^l ms apart.  A sleeper's qkey holds the wheel time it wakes
+ * at; it goes on the level 0 slot for that time if it is within
+ * TW_SLOTS ms, else on the slot of the first level that reaches it.
+ * When the wheel time crosses a level l slot boundary, that level's
+ * current slot is emptied onto the levels below, so a sleeper moves
+ * down at most TW_LEVELS - 1 times.  Inserting and cancelling are a
+ * list insert and delete; a clock tick looks at one slot, and rarely
+ * a few more, however many processes sleep.  Sleeps longer than
+ * TW_RANGE wait in the last slot reachable and are placed again from
+ * there.
+ *
+ * The wheel keeps its own time, twnow, advanced by the clock only while
+ * someone sleeps; sleep times are relative to it.
+ */
+
+int	twhead;				/* list head of slot 0, level 0	*/
+unsigned long	twnow;			/* wheel time, ms		*/
+
+LOCAL	void	twplace(int);
+
+/*------------------------------------------------------------------------
+ * twinit  --  make the wheel's slot lists, all empty
+ *------------------------------------------------------------------------
+ */
+void twinit(void)
+{
+	int	i;
+
+	twhead = newqueue();
+	for (i = 1; i < NTWSLOT; i++)
+		newqueue();		/* consecutive head/tail pairs	*/
+	twnow = 0;
+	slnempty = 0;
+}
+
+/*------------------------------------------------------------------------
+ * twinsert  --  put pid on the wheel to be made ready in ms ticks;
+ *		 interrupts are disabled
+ *------------------------------------------------------------------------
+ */
+void twinsert(int pid, unsigned long ms)
+{
+	clksync();			/* the wheel may be behind	*/
+	if (ms == 0)			/* at the next tick, as before	*/
+		ms = 1;
+	q[pid].qkey = (int) (twnow + ms);
+	twplace(pid);
+	slnempty++;
+}
+
+/*------------------------------------------------------------------------
+ * twremove  --  take sleeping pid off the wheel
+ *------------------------------------------------------------------------
+ */
+void twremove(int pid)
+{
+	dequeue(pid);
+	slnempty--;
+}
+
+/*------------------------------------------------------------------------
+ * twadvance  --  move the wheel ticks ms on, making ready (without
+ *		  rescheduling) everyone whose time comes, and return how
+ *		  many there were
+ *------------------------------------------------------------------------
+ */
+int twadvance(unsigned long ticks)
+{
+	int	head, l, pid, woke;
+
+	woke = 0;
+	while (ticks-- > 0) {
+		twnow++;
+		for (l = 1; l < TW_LEVELS &&
+		     (twnow & ((1UL << (TW_BITS * l)) - 1)) == 0; l++) {
+			head = twslot(l, (twnow >> (TW_BITS * l)) & TW_MASK);
+			while (nonempty(head))
+				twplace(getfirst(head));
+		}
+		head = twslot(0, twnow & TW_MASK);
+		while (nonempty(head)) {
+			pid = getfirst(head);
+			slnempty--;
+			ready(pid, RESCHNO);
+			woke++;
+		}
+	}
+	return(woke);
+}
+
+/*------------------------------------------------------------------------
+ * twnext  --  return how many ms the wheel can go without a tick: to
+ *	       the first level 0 sleeper or the next cascade, whichever
+ *	       comes first
+ *------------------------------------------------------------------------
+ */
+unsigned long twnext(void)
+{
+	unsigned long	t;
+
+	if (slnempty == 0)
+		return(TW_RANGE);
+	for (t = twnow + 1; (t & TW_MASK) != 0; t++)
+		if (nonempty(twslot(0, t & TW_MASK)))
+			break;
+	return(t - twnow);
+}
+
+/*------------------------------------------------------------------------
+ * twplace  --  put pid, whose qkey is its wake time, on its slot
+ *------------------------------------------------------------------------
+ */
+LOCAL void twplace(int pid)
+{
+	unsigned long	when;
+	int	l;
+
+	when = (unsigned long) q[pid].qkey;
+	if (when - twnow >= TW_RANGE)	/* beyond the wheel for now	*/
+		when = twnow + TW_RANGE - 1;
+	for (l = 0; l < TW_LEVELS - 1 &&
+	     when - twnow >= (1UL << (TW_BITS * (l + 1))); l++)
+		;
+	enqueue(pid, twslot(l, (when >> (TW_BITS * l)) & TW_MASK) + 1);
+}